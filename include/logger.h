@@ -30,6 +30,7 @@
 #include <FreeRTOS.h>
 #include <os_task.h>
 #include <os_semphr.h>
+#include <os_queue.h>
 
 #include "main/system.h"
 
@@ -41,6 +42,11 @@
 /********************************************************************************/
 /* Defines																		*/
 /********************************************************************************/
+/* Returned by the red_*( ) calls that fail. */
+#ifndef RED_FILE_ERR
+#define RED_FILE_ERR -1
+#endif
+
 #define LOGGER_TOTAL_SEQUENCE_BYTES 3
 #define LOGGER_SEQUENCE_START 0
 #define LOGGER_SEQUENCE_BASE 16
@@ -48,10 +54,70 @@
 #define LOGGER_MAX_CAPACITY (LOGGER_SEQUENCE_BASE*LOGGER_SEQUENCE_BASE*LOGGER_SEQUENCE_BASE) /* DO NOT CHANGE THIS DERRRR */ /* Numbers greater cause overflow in an undefined way */
 #define LOGGER_MIN_CAPCITY (2)
 
+/* Wide loggers, see initialize_wide_logger( ). Element names carry a 32 bit temporal number */
+/* in base 32, the slot is kept in the control data. Capacity is limited by the journal's */
+/* 24 bit sequence field. */
+#define LOGGER_WIDE_MAX_CAPACITY ((size_t) 1 << 24)
+#define LOGGER_WIDE_TEMPORAL_BYTES 7
+#define LOGGER_WIDE_ELEMENT_EXTENSION ".lgw"
+
 #define LOGGER_MAX_TEMPORAL_POINTS (10*10*10*10)
 #define LOGGER_TOTAL_TEMPORAL_BYTES 4
 #define LOGGER_TEMPORAL_START (LOGGER_SEQUENCE_START+LOGGER_TOTAL_SEQUENCE_BYTES+1)
 
+#define LOGGER_TOTAL_POPPED_BYTES 7
+
+/* Bytes logger_append( ) stages in RAM before writing to the HEAD. Writes land on multiples of this in the file. */
+#ifndef LOGGER_APPEND_BUFFER_SIZE
+#define LOGGER_APPEND_BUFFER_SIZE 512
+#endif
+
+/* Directory scanned for element files when the occupancy bitmap is built. */
+#ifndef LOGGER_ELEMENT_DIRECTORY
+#define LOGGER_ELEMENT_DIRECTORY "/"
+#endif
+
+/* Byte quota that never evicts, only turns on byte accounting. See logger_set_quota( ). */
+#define LOGGER_QUOTA_UNLIMITED (~(uint64_t) 0)
+
+/* Files kept next to the control file are named after all of it with one of these appended, */
+/* for example ctrl.dat is journaled in ctrl.dat.jnl. They are 4 characters long. */
+#define LOGGER_SIBLING_NAME_LENGTH (FILESYSTEM_MAX_NAME_LENGTH+4)
+
+/* Extension of the metadata journal, see logger_set_journal( ). */
+#define LOGGER_JOURNAL_EXTENSION ".jnl"
+
+/* Extension of the time index, see logger_set_time_source( ). */
+#define LOGGER_INDEX_EXTENSION ".tix"
+
+/* Extension of the element checksums, see logger_set_checksums( ). */
+#define LOGGER_CHECKSUM_EXTENSION ".sum"
+
+/* Words in the occupancy bitmap, one bit per slot. */
+#define LOGGER_OCCUPANCY_WORDS ((LOGGER_MAX_CAPACITY + 31) / 32)
+
+/* Most pre-created files a logger keeps, see logger_set_pool( ). */
+#define LOGGER_POOL_MAX 32
+#define LOGGER_POOL_EXTENSION ".pol"
+
+/* Retired elements the writer task renames or deletes per request, see logger_set_retire( ). */
+#ifndef LOGGER_SWEEP_BATCH
+#define LOGGER_SWEEP_BATCH 8
+#endif
+
+/* Bytes of an element logger_read_chunk( ) reads at a time, the most one chunk can hold. */
+#ifndef LOGGER_READ_AHEAD_SIZE
+#define LOGGER_READ_AHEAD_SIZE 1024
+#endif
+
+/* Writer task, see logger_task( ). */
+#ifndef LOGGER_WRITER_QUEUE_LENGTH
+#define LOGGER_WRITER_QUEUE_LENGTH 16
+#endif
+#ifndef LOGGER_WRITER_GROUP_SIZE
+#define LOGGER_WRITER_GROUP_SIZE 8	/* Most requests committed together. */
+#endif
+
 /* Configuration defines from filesystems*/
 #define FILESYSTEM_FATFS_MAX_FILE_HANDLES 	20
 #ifdef NANOMIND
@@ -67,6 +133,17 @@
 #define MUTEX_FALSE (bool_t)0
 #define mutex_t SemaphoreHandle_t
 #define DEV_ASSERT( pointer ) configASSERT( (pointer) )
+#ifndef LOGGER_MEMORY_BARRIER
+#define LOGGER_MEMORY_BARRIER() __sync_synchronize()
+#endif
+/* Index of the lowest set bit, word must not be zero. */
+#ifndef LOGGER_FIND_FIRST_SET
+#define LOGGER_FIND_FIRST_SET( word ) ((uint32_t) __builtin_ctz(word))
+#endif
+/* Index of the highest set bit, word must not be zero. */
+#ifndef LOGGER_FIND_LAST_SET
+#define LOGGER_FIND_LAST_SET( word ) ((uint32_t) (31 - __builtin_clz(word)))
+#endif
 
 
 
@@ -102,6 +179,12 @@
  * 		<li><b>X</b>: Has the same meaning as before.</li>
  * 		<li><b>aaaaaaa</b>: Is a relative number. This number is incremented for each file that gets popped. A small value indicates the file
  * 		popped earlier than a file with a large value. Of course, this number rolls over.
+ *
+ * 		Loggers made with initialize_wide_logger( ) name their elements:
+ * 		<br><b>bbbbbbbX.lgw</b>
+ * 		<br>Where <b>bbbbbbb</b> is a 32 bit temporal number in base 32 (0-9, a-v), so names still sort in
+ * 		insertion order. It only rolls over after 2^32 inserts. The position of the file in the ring buffer
+ * 		is not part of the name, it is derived from the HEAD kept in the control data.
  * @var logger_t::control_file_name;
  * 		<b>Private</b>
  * 		The name of a file which contains meta data about packet files. The file is structured
@@ -110,14 +193,146 @@
  * 		| HEAD sequence data (3 bytes) | HEAD temporal data (4 bytes) | popped temporal data (7 bytes) | reserved (2 bytes) |
  * 		<b>Private</b>
  * 		Length of logger_t::_packet_name_, does not include the null character.
+ * @var logger_t::journal_file_name
+ * 		<b>Private</b>
+ * 		Name of the metadata journal, derived from logger_t::control_file_name.
+ * @var logger_t::journal_interval
+ * 		<b>Private</b>
+ * 		Journal records between checkpoints, 0 when the journal is disabled.
+ * @var logger_t::journal_records
+ * 		<b>Private</b>
+ * 		Records in the journal since the last checkpoint.
+ * @var logger_t::index_file_name
+ * 		<b>Private</b>
+ * 		Name of the time index, derived from logger_t::control_file_name. Holds one record per slot:
+ * 		| timestamp (4 bytes) | temporal data ^ LOGGER_INDEX_KEY (4 bytes) |
+ * @var logger_t::time_source
+ * 		<b>Private</b>
+ * 		Stamps inserted elements in the time index, NULL when the index is not kept.
+ * @var logger_t::checksum_file_name
+ * 		<b>Private</b>
+ * 		Name of the element checksums, derived from logger_t::control_file_name. Holds one record per slot:
+ * 		| crc32 (4 bytes) | length (4 bytes) | temporal data ^ LOGGER_CHECKSUM_KEY (4 bytes) |
+ * @var logger_t::checksums
+ * 		<b>Private</b>
+ * 		Set when logger_append( ) keeps the CRC of the HEAD and it is recorded when the HEAD is closed.
  * @var logger_t::element_file_name
  * 		The unique name of elements in the ring buffer.
+ * @var logger_t::pool_size
+ * 		<b>Private</b>
+ * 		Pre-created files to keep, 0 when there is no pool. See logger_set_pool( ).
+ * @var logger_t::pool_ready
+ * 		<b>Private</b>
+ * 		Bit set for each pool file that exists and can be claimed.
+ * @var logger_t::pool_queued
+ * 		<b>Private</b>
+ * 		Set while a refill request is waiting in the writer task's queue.
+ * @var logger_t::wide
+ * 		<b>Private</b>
+ * 		Set for loggers made with initialize_wide_logger( ).
+ * @var logger_t::occupancy
+ * 		<b>Private</b>
+ * 		Points to logger_t::occupancy_storage, or to storage given to initialize_wide_logger( ). One bit per slot, set while the slot's element file is believed to exist. Built with one
+ * 		directory scan and kept up to date by insert, pop and eviction. Bits for files removed
+ * 		behind the logger's back are only cleared once logger_update_tail( ) trips over them.
+ * @var logger_t::occupancy_words
+ * 		<b>Private</b>
+ * 		Number of words at logger_t::occupancy.
+ * @var logger_t::occupancy_storage
+ * 		<b>Private</b>
+ * 		Bitmap used by loggers made with initialize_logger( ).
+ * @var logger_t::byte_quota
+ * 		<b>Private</b>
+ * 		Most bytes the logger's elements may take up, 0 for no limit. See logger_set_quota( ).
+ * @var logger_t::bytes_stored
+ * 		<b>Private</b>
+ * 		Bytes in the logger's elements. Built by the occupancy scan and kept up to date by insert,
+ * 		append, pop and eviction while logger_t::byte_quota is set.
+ * @var logger_t::element_bytes
+ * 		<b>Private</b>
+ * 		Bytes counted in logger_t::bytes_stored for each slot's element, NULL if not kept. See
+ * 		logger_set_size_table( ).
+ * @var logger_t::quota
+ * 		<b>Private</b>
+ * 		Shared budget the logger is registered with, NULL if none. See logger_quota_register( ).
+ * @var logger_t::occupancy_valid
+ * 		<b>Private</b>
+ * 		Cleared whenever the control data is (re)loaded, logger_t::occupancy is rebuilt on next use.
+ * @var logger_t::head_handle
+ * 		<b>Private</b>
+ * 		Handle logger_append( ) keeps open on the HEAD, RED_FILE_ERR when closed. Closed whenever the HEAD moves.
+ * @var logger_t::head_size
+ * 		<b>Private</b>
+ * 		Size of the HEAD file as seen through logger_t::head_handle, including staged bytes.
+ * @var logger_t::head_opened
+ * 		<b>Private</b>
+ * 		Tick count when logger_t::head_handle was opened, used for age based rotation.
+ * @var logger_t::head_rotate
+ * 		<b>Private</b>
+ * 		Set when logger_flush( ) closed the HEAD for its age, the next logger_append( ) starts a new element.
+ * @var logger_t::head_crc
+ * 		<b>Private</b>
+ * 		CRC-32 of the logger_t::head_size bytes appended to the HEAD.
+ * @var logger_t::head_crc_valid
+ * 		<b>Private</b>
+ * 		Clear when logger_t::head_crc doesn't cover all of the HEAD, for example when it was reopened
+ * 		without a record or a write failed.
+ * @var logger_t::rotate_size
+ * 		<b>Private</b>
+ * 		Size in bytes at which logger_append( ) starts a new element. 0 to disable.
+ * @var logger_t::rotate_age
+ * 		<b>Private</b>
+ * 		Age in ticks at which logger_append( ) starts a new element. 0 to disable.
+ * @var logger_t::append_buffer
+ * 		<b>Private</b>
+ * 		Bytes staged by logger_append( ) not yet written to the HEAD.
+ * @var logger_t::append_length
+ * 		<b>Private</b>
+ * 		Number of bytes in logger_t::append_buffer.
+ * @var logger_t::head
+ * 		<b>Private</b>
+ * 		Cached position of the HEAD. Valid while logger_t::control_data_cached is set.
+ * @var logger_t::tail
+ * 		<b>Private</b>
+ * 		Cached position of the TAIL. Valid while logger_t::control_data_cached is set.
+ * @var logger_t::head_file_name
+ * 		<b>Private</b>
+ * 		logger_t::head rendered as a file name, kept for the lock free readers.
+ * @var logger_t::tail_file_name
+ * 		<b>Private</b>
+ * 		logger_t::tail rendered as a file name, kept for the lock free readers.
+ * @var logger_t::popped_point
+ * 		<b>Private</b>
+ * 		Cached popped temporal point.
+ * @var logger_t::retire_mode
+ * 		<b>Private</b>
+ * 		See logger_set_retire( ).
+ * @var logger_t::retired
+ * 		<b>Private</b>
+ * 		Oldest element popped but not yet swept. Elements from here up to the TAIL still have their
+ * 		element names. Equal to the TAIL when there is nothing to sweep, and follows it while it is.
+ * 		Not kept in the control data, the occupancy scan finds the unswept files again.
+ * @var logger_t::sweep_queued
+ * 		<b>Private</b>
+ * 		Set while a sweep request is waiting in the writer task's queue.
+ * @var logger_t::control_data_cached
+ * 		<b>Private</b>
+ * 		Set once the control file has been read. The cache is written through on every change
+ * 		and only re-read from the control file by logger_revalidate( ) or after a failed write.
+ * @var logger_t::control_generation
+ * 		<b>Private</b>
+ * 		Generation of the newest record in the control file. The next record goes in the other slot.
+ * @var logger_t::control_version
+ * 		<b>Private</b>
+ * 		Odd while the cached control data is being changed, incremented twice per change. Lets
+ * 		logger_peek_head( ) and logger_peek_tail( ) read the cache without the mutex.
  * @var logger_t::filesystem;
  * 		<b>Private</b>
  * 		The filesystem used by the logger.
  * @var logger_t::sync_mutex;
  * 		<b>Private</b>
- * 		Mutex used for mutual exclusion. This is a singleton shared by all logger instances.
+ * 		Mutex used for mutual exclusion. Each logger instance has its own, so loggers working on
+ * 		different files never wait on each other.
  */
 typedef struct logger_t logger_t;
 
@@ -130,9 +345,119 @@ typedef enum
 	LOGGER_MUTEX_ERR,	/*!< (2) Failed to create synchronization objects. */
 	LOGGER_EMPTY,		/*!< (3) No files in the loggers buffer to peek / pop. */
 	LOGGER_NVMEM_FULL,	/*!< (4) Non volatile memory is full. */
-	LOGGER_INV_CAP		/*!< (5) Returns by constructor when an invalid capacity is used. */
+	LOGGER_INV_CAP,		/*!< (5) Returns by constructor when an invalid capacity is used. */
+	LOGGER_INV_NAME,	/*!< (6) Returns by constructor when the element file name is used by another logger. */
+	LOGGER_BUSY,		/*!< (7) The writer task's queue is full, nothing was queued. */
+	LOGGER_TABLE_FULL	/*!< (8) A fixed size table has no room left, see logger_quota_register( ). */
 } logger_error_t;
 
+/** What logger_pop( ) does with the file it removes from the ring buffer, see logger_set_retire( ). */
+typedef enum
+{
+	LOGGER_RETIRE_NOW = 0,	/*!< (0) Renamed to Xaaaaaaa.bin before logger_pop( ) returns. */
+	LOGGER_RETIRE_RENAME,	/*!< (1) Left under its element name, renamed to Xaaaaaaa.bin by logger_sweep( ). */
+	LOGGER_RETIRE_DELETE	/*!< (2) Left under its element name, deleted by logger_sweep( ). */
+} logger_retire_t;
+
+/**
+ * Position of an element in the ring buffer, held in binary. File names are only
+ * rendered from it when the file system needs one.
+ */
+typedef struct
+{
+	uint32_t	sequence;	/*!< Slot, 0 to logger_t::max_capacity-1. */
+	uint32_t	temporal;	/*!< Insertion counter, 0 to LOGGER_MAX_TEMPORAL_POINTS-1 (any value for wide loggers). */
+} logger_position_t;
+
+/** A chunk of an element returned by logger_read_chunk( ). */
+typedef struct
+{
+	logger_position_t	element;	/*!< Element the chunk was read from. */
+	uint32_t			offset;		/*!< Where the chunk starts in the element. */
+	size_t				length;		/*!< Bytes in the chunk. */
+	uint32_t			crc;		/*!< CRC-32 of the chunk, see logger_crc32( ). */
+} logger_chunk_t;
+
+/**
+ * Called by the writer task once a queued request is on flash (or failed).
+ * @param logger
+ * 		The logger the request was for.
+ * @param err
+ * 		The result of the request.
+ * @param arg
+ * 		The argument given when the request was queued.
+ */
+typedef void (*logger_callback_t)( logger_t* logger, logger_error_t err, void* arg );
+
+/**
+ * Gives the time an element is inserted at, for example seconds since an epoch from the RTC.
+ * Must not go backwards, see logger_find_range( ).
+ */
+typedef uint32_t (*logger_time_source_t)( void );
+
+
+/**
+ * @struct logger_iterator_t
+ * @brief
+ * 		Walks the elements of a logger_t, see logger_iterate( ).
+ * @var logger_iterator_t::logger
+ * 		<b>Private</b>
+ * 		The logger being walked.
+ * @var logger_iterator_t::position
+ * 		<b>Private</b>
+ * 		Next position to look at.
+ * @var logger_iterator_t::remaining
+ * 		<b>Private</b>
+ * 		Slots left to look at.
+ * @var logger_iterator_t::forward
+ * 		<b>Private</b>
+ * 		Set when walking from TAIL to HEAD.
+ */
+typedef struct logger_iterator_t logger_iterator_t;
+
+/**
+ * @struct logger_cursor_t
+ * @brief
+ * 		Appends to a logger_t through the handle it keeps open on the HEAD, see logger_cursor_open( ).
+ * @var logger_cursor_t::logger
+ * 		<b>Private</b>
+ * 		The logger written to.
+ * @var logger_cursor_t::element
+ * 		Read only. Position of the element the last record went into.
+ * @var logger_cursor_t::offset
+ * 		Read only. Where the last record starts in that element.
+ */
+typedef struct logger_cursor_t logger_cursor_t;
+
+/**
+ * @struct logger_read_cursor_t
+ * @brief
+ * 		Reads the elements of a logger_t in chunks, oldest first, see logger_read_chunk( ).
+ * @details
+ * 		logger_read_cursor_t::element and logger_read_cursor_t::offset are all there is to resume
+ * 		reading. Save them, after a reboot pass them to initialize_logger_read_cursor( ).
+ * @var logger_read_cursor_t::element
+ * 		Read only. Element being read.
+ * @var logger_read_cursor_t::offset
+ * 		Read only. Bytes of logger_read_cursor_t::element already returned.
+ * @var logger_read_cursor_t::started
+ * 		<b>Private</b>
+ * 		Clear until logger_read_cursor_t::element is known, reading then starts at the TAIL.
+ * @var logger_read_cursor_t::handle
+ * 		<b>Private</b>
+ * 		Open on logger_read_cursor_t::element, or RED_FILE_ERR.
+ * @var logger_read_cursor_t::ahead
+ * 		<b>Private</b>
+ * 		Bytes read from the element but not returned yet.
+ * @var logger_read_cursor_t::ahead_position
+ * 		<b>Private</b>
+ * 		First byte of logger_read_cursor_t::ahead not returned yet.
+ * @var logger_read_cursor_t::ahead_length
+ * 		<b>Private</b>
+ * 		Bytes in logger_read_cursor_t::ahead.
+ */
+typedef struct logger_read_cursor_t logger_read_cursor_t;
+
 
 /********************************************************************************/
 /* Structure Definition															*/
@@ -142,14 +467,78 @@ struct logger_t
 	void (*destroy)( logger_t * );
 
 	char	 			control_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	char	 			journal_file_name[LOGGER_SIBLING_NAME_LENGTH+1];
+	uint32_t			journal_interval;
+	uint32_t			journal_records;
+	char	 			index_file_name[LOGGER_SIBLING_NAME_LENGTH+1];
+	logger_time_source_t	time_source;
+	char	 			checksum_file_name[LOGGER_SIBLING_NAME_LENGTH+1];
+	bool_t				checksums;
 	char				element_file_name;
+	logger_position_t	head;
+	logger_position_t	tail;
 	char 				head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
 	char				tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t			popped_point;
+	logger_retire_t		retire_mode;
+	logger_position_t	retired;
+	bool_t				sweep_queued;
+	size_t				pool_size;
+	uint32_t			pool_ready;
+	bool_t				pool_queued;
+	bool_t				wide;
+	uint32_t*			occupancy;
+	size_t				occupancy_words;
+	uint32_t			occupancy_storage[LOGGER_OCCUPANCY_WORDS];
+	bool_t				occupancy_valid;
+	uint64_t			byte_quota;
+	uint64_t			bytes_stored;
+	uint32_t*			element_bytes;
+	struct logger_quota_t*	quota;
+	bool_t				control_data_cached;
+	uint32_t			control_generation;
+	volatile uint32_t	control_version;
+	int32_t				head_handle;
+	size_t				head_size;
+	TickType_t			head_opened;
+	bool_t				head_rotate;
+	uint32_t			head_crc;
+	bool_t				head_crc_valid;
+	size_t				rotate_size;
+	TickType_t			rotate_age;
+	uint8_t				append_buffer[LOGGER_APPEND_BUFFER_SIZE];
+	size_t				append_length;
 	FILE				*fs;
-	SemaphoreHandle_t	*sync_mutex;
+	SemaphoreHandle_t	sync_mutex;
 	size_t				max_capacity;
 };
 
+struct logger_iterator_t
+{
+	logger_t*			logger;
+	logger_position_t	position;
+	uint32_t			remaining;
+	bool_t				forward;
+};
+
+struct logger_cursor_t
+{
+	logger_t*			logger;
+	logger_position_t	element;
+	size_t				offset;
+};
+
+struct logger_read_cursor_t
+{
+	logger_position_t	element;
+	uint32_t			offset;
+	bool_t				started;
+	int32_t				handle;
+	uint8_t				ahead[LOGGER_READ_AHEAD_SIZE];
+	size_t				ahead_position;
+	size_t				ahead_length;
+};
+
 
 /********************************************************************************/
 /* Non Virtual Method Declares													*/
@@ -163,6 +552,8 @@ struct logger_t
  * 		Use this to get a handle for the file at the HEAD of the ring buffer. If the ring buffer is empty
  * 		an error code is returned.
  * 		<br><b>The location of the write cursor is at the end of the file.</b>
+ * 		<br>Does not block on other callers unless the HEAD is being moved at that moment.
+ * 		<br>For repeated appends use logger_append( ) or logger_cursor_open( ), which keep the HEAD open.
  * @attention
  * 		Successive calls will result in duplicate file opening.
  * @attention
@@ -193,6 +584,28 @@ int32_t logger_peek_head( logger_t*, logger_error_t* err );
  */
 int32_t logger_insert( logger_t*, logger_error_t* err, char const* file_name );
 
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Insert several files into the ring buffer at once.
+ * @details
+ * 		Behaves like calling logger_insert( ) once per file, in order, but takes the lock once, evicts as
+ * 		many TAIL elements as needed in one pass and writes the control file once at the end. No handles
+ * 		are returned.
+ * 		<br>If a file fails to be inserted the files before it remain in the ring buffer and the files
+ * 		after it are not touched.
+ * @param file_names[in]
+ * 		Names of the files to insert, each up to FILESYSTEM_MAX_NAME_LENGTH bytes. All references (handles)
+ * 		to these files MUST be closed. A NULL entry inserts an empty file.
+ * @param count
+ * 		The number of entries in <b>file_names</b>.
+ * @param inserted[out]
+ * 		The number of files now tracked by the ring buffer. Pass as NULL to ignore it.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_insert_batch( logger_t*, char const* const file_names[], size_t count, size_t* inserted );
+
 /**
  * @memberof logger_t
  * @brief
@@ -202,6 +615,7 @@ int32_t logger_insert( logger_t*, logger_error_t* err, char const* file_name );
  * 		not removed from the buffer. <b>The file pointer will be at the beginning of the file.</b> Note, this
  * 		is different from logger_peek_head( ) where the file pointer is at the end of the file.
  * 		Must always call file_t::close( ) when finished regardless of error code.
+ * 		<br>Does not block on other callers unless the TAIL has to be moved past asynchronously removed files.
  * @param err[out]
  * 		Error code. This argument must point to valid memory.
  * @returns
@@ -210,6 +624,54 @@ int32_t logger_insert( logger_t*, logger_error_t* err, char const* file_name );
  */
 int32_t logger_peek_tail( logger_t*, logger_error_t* err );
 
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Peek at any element in the ring buffer.
+ * @details
+ * 		The element is found arithmetically from the TAIL, nothing is renamed and the ring buffer
+ * 		is not changed. The file pointer will be at the beginning of the file. Must always call
+ * 		file_t::close( ) when finished regardless of error code.
+ * @param index
+ * 		Slots from the TAIL, 0 is the TAIL. Slots left empty by asynchronous file removal still count.
+ * @param err[out]
+ * 		LOGGER_EMPTY if <b>index</b> is past the HEAD or its file has been removed, otherwise an error code.
+ * 		This argument must point to valid memory.
+ * @returns
+ * 		An opened handle for the file.
+ */
+int32_t logger_peek_at( logger_t*, size_t index, logger_error_t* err );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Start iterating over the elements in the ring buffer.
+ * @details
+ * 		Takes a snapshot of the span from TAIL to HEAD. Elements are then given by logger_iterator_next( )
+ * 		without renaming or opening anything. Slots emptied by asynchronous file removal are skipped
+ * 		using the occupancy bitmap, as are elements popped or evicted while iterating. Elements inserted
+ * 		after this call are not seen.
+ * @param iterator[out]
+ * 		The iterator.
+ * @param from_head
+ * 		true to go from the HEAD back to the TAIL (newest first, for "the last N files"), false to go
+ * 		from the TAIL to the HEAD.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_iterate( logger_t*, logger_iterator_t* iterator, bool_t from_head );
+
+/**
+ * @memberof logger_iterator_t
+ * @brief
+ * 		Get the next element.
+ * @param file_name[out]
+ * 		Name of the element. Must point to at least FILESYSTEM_MAX_NAME_LENGTH+1 bytes.
+ * @returns
+ * 		LOGGER_EMPTY once there are no more elements, otherwise an error code.
+ */
+logger_error_t logger_iterator_next( logger_iterator_t*, char* file_name );
+
 /**
  * @memberof logger_t
  * @brief
@@ -226,10 +688,409 @@ int32_t logger_peek_tail( logger_t*, logger_error_t* err );
  */
 logger_error_t logger_pop( logger_t*, char* popped_file_name );
 
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Remove a run of files from the ring buffer's TAIL.
+ * @details
+ * 		Same as calling logger_pop( ) up to <b>max</b> times, but the popped temporal data and the TAIL
+ * 		are each written to the control file once for the whole run. Files asynchronously removed
+ * 		from the ring buffer are skipped and don't count towards <b>max</b>.
+ * 		The file at the HEAD is never popped.
+ * @param max
+ * 		The maximum number of files to pop.
+ * @param popped_file_names[out]
+ * 		The new names of the popped files, oldest first. Must have room for <b>max</b> names.
+ * 		Pass as NULL to ignore them.
+ * @param popped[out]
+ * 		The number of files popped. Must point to valid memory.
+ * @returns
+ * 		An error code. LOGGER_EMPTY if nothing could be popped.
+ */
+logger_error_t logger_pop_n( logger_t*, size_t max, char popped_file_names[][FILESYSTEM_MAX_NAME_LENGTH+1], size_t* popped );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Append a record to the HEAD.
+ * @details
+ * 		Records are staged in RAM and written to the HEAD in LOGGER_APPEND_BUFFER_SIZE blocks through a handle
+ * 		the logger keeps open. A new element is started when the HEAD would grow past the rotation size, or
+ * 		has been open longer than the rotation age, see logger_set_rotation( ). A record is never split
+ * 		across two elements.
+ * 		<br>Staged data is not visible through logger_peek_head( ) until logger_flush( ) is called, the
+ * 		HEAD rotates, or a file is inserted.
+ * @param buffer[in]
+ * 		The record.
+ * @param length
+ * 		Length of the record in bytes.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_append( logger_t*, void const* buffer, size_t length );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Write data staged by logger_append( ) to the HEAD.
+ * @details
+ * 		The HEAD stays open for further appends, unless it is older than the rotation age, in which case it is closed
+ * 		and the next logger_append( ) starts a new element.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_flush( logger_t* );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Close off the HEAD, the next logger_append( ) starts a new element.
+ * @details
+ * 		Staged data is written first. Nothing changes if the HEAD isn't open for appending.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_rotate( logger_t* );
+
+/**
+ * @memberof logger_cursor_t
+ * @brief
+ * 		Get an append cursor on the HEAD.
+ * @details
+ * 		The HEAD is opened now, if it isn't already, so the first logger_cursor_write( ) costs no more
+ * 		than the rest. All cursors on a logger share the one handle the logger keeps on the HEAD, which is
+ * 		only reopened when the HEAD rotates or a file is inserted. Cursors hold no resources of their own.
+ * @param cursor[out]
+ * 		The cursor.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_cursor_open( logger_t*, logger_cursor_t* cursor );
+
+/**
+ * @memberof logger_cursor_t
+ * @brief
+ * 		Append a record, as logger_append( ) does.
+ * @details
+ * 		Afterwards logger_cursor_t::element and logger_cursor_t::offset say where the record went.
+ * @param buffer[in]
+ * 		The record.
+ * @param length
+ * 		Length of the record in bytes.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_cursor_write( logger_cursor_t*, void const* buffer, size_t length );
+
+/**
+ * @memberof logger_cursor_t
+ * @brief
+ * 		Cut the HEAD back to <b>offset</b> bytes.
+ * @details
+ * 		For taking back records after a failed logger_cursor_write( ), which only removes the part
+ * 		of its own record that reached the file. Staged data is written first. Unless it is cut
+ * 		back to empty, the HEAD's checksum is not recorded when it is closed.
+ * @param offset
+ * 		New length of the cursor's element.
+ * @returns
+ * 		LOGGER_INV_CAP if the HEAD is no longer the cursor's element or is shorter than
+ * 		<b>offset</b>, otherwise an error code.
+ */
+logger_error_t logger_cursor_truncate( logger_cursor_t*, size_t offset );
+
+/**
+ * @memberof logger_cursor_t
+ * @brief
+ * 		Done with a cursor, writes what it staged, as logger_flush( ) does.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_cursor_close( logger_cursor_t* );
+
+/**
+ * @memberof logger_read_cursor_t
+ * @brief
+ * 		Read the next chunk of the ring buffer.
+ * @details
+ * 		Chunks come from one element at a time, oldest first, and never span two elements. When an
+ * 		element is finished the cursor moves on to the next one that is still in the ring buffer. If
+ * 		its element was popped or overwritten the cursor starts again at the TAIL.
+ * 		<br>The element is read LOGGER_READ_AHEAD_SIZE bytes at a time, and a chunk is topped
+ * 		up from the following read, so small chunks cost a copy rather than a file system call.
+ * 		Only what is on flash is read, see logger_flush( ).
+ * @param cursor[in/out]
+ * 		The cursor, see initialize_logger_read_cursor( ).
+ * @param buffer[out]
+ * 		Where the chunk is copied.
+ * @param size
+ * 		Size of <b>buffer</b>. Chunks are at most LOGGER_READ_AHEAD_SIZE bytes.
+ * @param chunk[out]
+ * 		Where the chunk came from, its length and its CRC.
+ * @returns
+ * 		LOGGER_EMPTY once everything up to the end of the HEAD has been read, more can be read
+ * 		after the HEAD grows. Otherwise an error code.
+ */
+logger_error_t logger_read_chunk( logger_t*, logger_read_cursor_t* cursor, void* buffer, size_t size, logger_chunk_t* chunk );
+
+/**
+ * @memberof logger_read_cursor_t
+ * @brief
+ * 		Done with a cursor, closes the element it has open.
+ */
+void logger_read_cursor_close( logger_read_cursor_t* cursor );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Set when logger_append( ) starts a new element.
+ * @param max_element_size
+ * 		A new element is started before the HEAD would grow past this many bytes. 0 to disable.
+ * @param max_element_age
+ * 		A new element is started once the HEAD has been appended to for this many ticks. 0 to disable.
+ */
+void logger_set_rotation( logger_t*, size_t max_element_size, TickType_t max_element_age );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Limit the bytes the logger's elements take up.
+ * @details
+ * 		Once set, logger_insert( ) and logger_append( ) evict from the TAIL until the total size of
+ * 		all elements is back under <b>max_bytes</b>, on top of the eviction done for logger_t::max_capacity.
+ * 		The HEAD is never evicted, so it alone may exceed the quota. The running total is kept in RAM,
+ * 		it is only rebuilt with a directory scan when the quota is first set or after files are found
+ * 		to have been removed asynchronously.
+ * @param max_bytes
+ * 		The quota, 0 to remove it.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_set_quota( logger_t*, uint64_t max_bytes );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Bytes in the logger's elements.
+ * @details
+ * 		Only kept up to date while a quota is set, see logger_set_quota( ). Data staged by logger_append( )
+ * 		counts once it is written to flash.
+ */
+uint64_t logger_bytes_stored( logger_t* );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Keep the size of every element in RAM while a quota is set.
+ * @details
+ * 		Without a table, popping or evicting an element under a quota opens it to read its size.
+ * 		With one, the size counted when the element was scanned, inserted or appended to is used,
+ * 		so no file is opened. The table is filled by the next occupancy scan.
+ * @param sizes
+ * 		One entry per slot, must remain valid while the logger is used. NULL to stop using a table.
+ * @param entries
+ * 		Entries in <b>sizes</b>, at least logger_t::max_capacity.
+ * @returns
+ * 		LOGGER_INV_CAP if <b>entries</b> is too small, otherwise LOGGER_OK.
+ */
+logger_error_t logger_set_size_table( logger_t*, uint32_t* sizes, size_t entries );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Delete the oldest element.
+ * @details
+ * 		Like logger_pop( ), but the file is deleted rather than renamed. Used by logger_quota_t, a byte
+ * 		quota (see logger_set_quota( )) must be set for <b>freed</b> to be accurate.
+ * @param freed[out]
+ * 		Bytes given back.
+ * @returns
+ * 		LOGGER_EMPTY if only the HEAD is left, otherwise an error code.
+ */
+logger_error_t logger_drop_tail( logger_t*, uint64_t* freed );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Journal control data changes instead of rewriting the control file.
+ * @details
+ * 		While enabled, every HEAD, TAIL and popped point change is appended to a small journal file
+ * 		next to the control file (same name, LOGGER_JOURNAL_EXTENSION extension) rather than
+ * 		rewriting a control record. Every <b>checkpoint_interval</b> records the state is written
+ * 		to the control file and the journal is emptied. initialize_logger( ) replays the journal
+ * 		whether or not it is enabled, so at most <b>checkpoint_interval</b> records are read at boot.
+ * @param checkpoint_interval
+ * 		Records between checkpoints. 0 checkpoints now and disables the journal.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_set_journal( logger_t*, uint32_t checkpoint_interval );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Keep a time index of the elements.
+ * @details
+ * 		While set, every inserted element (including those started by logger_append( )) is stamped with
+ * 		<b>source</b> in a small index file next to the control file (same name, LOGGER_INDEX_EXTENSION
+ * 		extension). One fixed size record per slot, so an insert costs one write and logger_find_range( )
+ * 		can binary search it. Elements inserted while no source was set are not in the index.
+ * @param source
+ * 		The time source, NULL to stop indexing.
+ */
+void logger_set_time_source( logger_t*, logger_time_source_t source );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Find the elements inserted between two times.
+ * @details
+ * 		Binary searches the time index, reading O(log n) records. The matching elements are consecutive,
+ * 		<b>*first</b> can be given straight to logger_peek_at( ). Elements not in the index are
+ * 		skipped over. Results are only exact if the time source never went backwards.
+ * @param start
+ * 		Earliest time, inclusive.
+ * @param end
+ * 		Latest time, inclusive.
+ * @param first[out]
+ * 		Index from the TAIL of the first element stamped at or after <b>start</b>.
+ * @param count[out]
+ * 		Elements from <b>*first</b> on stamped at or before <b>end</b>. Some may have been removed
+ * 		asynchronously since.
+ * @returns
+ * 		LOGGER_EMPTY if no element is in range, otherwise an error code.
+ */
+logger_error_t logger_find_range( logger_t*, uint32_t start, uint32_t end, size_t* first, size_t* count );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Keep a checksum of every element appended.
+ * @details
+ * 		While set, logger_append( ) updates a CRC-32 of the HEAD with the data it is given, and when the HEAD
+ * 		is closed the CRC and length are recorded in a small file next to the control file (same name,
+ * 		LOGGER_CHECKSUM_EXTENSION extension). One fixed size record per slot, so closing an element costs
+ * 		one write and logger_element_checksum( ) one read, instead of a pass over the element.
+ * 		<br>Data put in the ring buffer with logger_insert( ) is not read by the logger, the first
+ * 		logger_element_checksum( ) of such an element reads it once and records the result.
+ * @param enable
+ * 		MUTEX_TURE to keep checksums, MUTEX_FALSE to stop.
+ */
+void logger_set_checksums( logger_t*, bool_t enable );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Get the CRC-32 and length of an element.
+ * @details
+ * 		Recorded checksums are returned without reading the element, see logger_set_checksums( ).
+ * 		Otherwise the element is read once, and the result recorded if checksums are kept. For the HEAD
+ * 		the staged append data is flushed first, so the result matches the file.
+ * @param index
+ * 		Index from the TAIL, as for logger_peek_at( ).
+ * @param crc[out]
+ * 		CRC-32 of the element, see logger_crc32( ).
+ * @param length[out]
+ * 		Length of the element in bytes.
+ * @returns
+ * 		LOGGER_EMPTY if there is no element at <b>index</b>, otherwise an error code.
+ */
+logger_error_t logger_element_checksum( logger_t*, size_t index, uint32_t* crc, uint32_t* length );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Choose what popping does with the popped files.
+ * @details
+ * 		With LOGGER_RETIRE_RENAME or LOGGER_RETIRE_DELETE, logger_pop( ) and logger_pop_n( ) only move the
+ * 		TAIL, a single control data update, and give back the element names of the popped files. Holes are
+ * 		found from the occupancy bitmap without probing the file system, so an element removed
+ * 		asynchronously since the last scan may be returned. The files are renamed or deleted later, in
+ * 		batches, by logger_sweep( ). Once LOGGER_SWEEP_BATCH files are waiting the writer task is asked to
+ * 		sweep if start_logger_task( ) has been called; otherwise the application calls logger_sweep( ).
+ * 		A popped file must not be used after the next sweep. Inserts sweep synchronously rather than reuse
+ * 		the slot of a file still waiting.
+ * @param mode
+ * 		LOGGER_RETIRE_NOW (the default) sweeps everything still waiting first.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_set_retire( logger_t*, logger_retire_t mode );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Keep a pool of empty files for new elements.
+ * @details
+ * 		Inserting an empty element (logger_insert( ) with NULL, or logger_append( ) starting a new one)
+ * 		then claims a pool file with a single rename, so file creation is off the caller's path. Pool
+ * 		files are named <b>Xpoolnnn.pol</b> after the logger's element name and are refilled by the
+ * 		writer task if start_logger_task( ) has been called, otherwise by logger_fill_pool( ). Once the
+ * 		pool runs dry, elements are created as before.
+ * 		<br>Pool files are empty, they are not pre-sized: logger_append( ) continues at the end of the
+ * 		HEAD file.
+ * 		<br>The pool is not remembered across a reset. Pool files left from before are deleted when
+ * 		the logger is initialized, call this again to rebuild the pool.
+ * @param size
+ * 		Files to keep, at most LOGGER_POOL_MAX. 0 removes the pool.
+ * @returns
+ * 		An error code, the pool is filled before returning.
+ */
+logger_error_t logger_set_pool( logger_t*, size_t size );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Create the pool files claimed since the last fill, see logger_set_pool( ).
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_fill_pool( logger_t* );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Rename or delete files popped since the last sweep, see logger_set_retire( ).
+ * @param max
+ * 		Most files to handle.
+ * @param swept[out]
+ * 		Files handled, including those already removed. May be NULL.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_sweep( logger_t*, size_t max, size_t* swept );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Re-read the control data from non volatile memory.
+ * @details
+ * 		After initialize_logger( ) the logger keeps its HEAD, TAIL and temporal data in RAM and
+ * 		only writes the control file when they change. Call this if the control file may have been
+ * 		modified behind the logger's back (for example, uploaded via FTP) to discard the cached
+ * 		copy and load it from the control file again.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_revalidate( logger_t* );
+
 
 /********************************************************************************/
 /* Initialization Method Declares												*/
 /********************************************************************************/
+/**
+ * @memberof logger_read_cursor_t
+ * @brief
+ * 		Initialize a logger_read_cursor_t structure.
+ * @details
+ * 		No file is opened until the first logger_read_chunk( ).
+ * @param element[in]
+ * 		Element to resume reading, as saved from logger_read_cursor_t::element. NULL to start at
+ * 		the TAIL.
+ * @param offset
+ * 		Bytes of <b>element</b> already read, as saved from logger_read_cursor_t::offset.
+ */
+void initialize_logger_read_cursor( logger_read_cursor_t *self, logger_position_t const* element, uint32_t offset );
+
 /**
  * @memberof logger_t
  * @brief
@@ -246,17 +1107,97 @@ logger_error_t logger_pop( logger_t*, char* popped_file_name );
  * @param control_file_name[in]
  * 		Must be a null terminated string indicating the name to use for ring buffer's control data.
  * 		This name is copied up to a maximum of FILESYSTEM_MAX_NAME_LENGTH bytes. This file must not be used.
+ * 		The journal, time index and checksums are kept in files named after it with 4 characters
+ * 		appended, see LOGGER_SIBLING_NAME_LENGTH.
  * @param element_file_name[in]
  * 		The name of file elements. This is used to differentiate between files of different sources when
- * 		they are viewed via an FTP service and to bind files to a logger_t instance.
+ * 		they are viewed via an FTP service and to bind files to a logger_t instance. No two initialized
+ * 		loggers may use the same element file name, LOGGER_INV_NAME is returned if it is taken.
  * @param max_capacity
  * 		The maximum number of files the ring buffer can hold. Must be between LOGGER_MIN_CAPACITY (2) and LOGGER_MAX_CAPACITY (1000).
  * @returns
  * 		An error code.
  */
 logger_error_t initialize_logger( logger_t *self,
-								  char const *control_file_name, char element_file_name, size_t max_capacity, bool_t logger_is_init);
+								  char const *control_file_name, char element_file_name, size_t max_capacity);
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Initialize a logger_t structure that can hold more than LOGGER_MAX_CAPACITY elements.
+ * @details
+ * 		Same as initialize_logger( ), but elements use the <b>bbbbbbbX.lgw</b> naming convention (see logger_t).
+ * 		Every operation costs the same as for a small logger, the only thing that grows with capacity is
+ * 		the occupancy bitmap, which the application provides.
+ * 		<br>A wide logger and a regular one cannot share a control file.
+ * @param max_capacity
+ * 		Must be between LOGGER_MIN_CAPACITY (2) and LOGGER_WIDE_MAX_CAPACITY.
+ * @param occupancy[in]
+ * 		One bit per element, at least (<b>max_capacity</b>+31)/32 words. Must remain valid for as long as
+ * 		the logger is used.
+ * @param occupancy_words
+ * 		Number of words at <b>occupancy</b>.
+ * @returns
+ * 		An error code. LOGGER_INV_CAP if <b>max_capacity</b> is out of range or <b>occupancy</b> is too small.
+ */
+logger_error_t initialize_wide_logger( logger_t *self, char const *control_file_name, char element_file_name,
+									   size_t max_capacity, uint32_t* occupancy, size_t occupancy_words );
+
+/********************************************************************************/
+/* Writer Task Method Declares													*/
+/********************************************************************************/
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Queue a file to be inserted by the writer task.
+ * @details
+ * 		Returns immediately. The writer task inserts the file as logger_insert( ) would, committing
+ * 		requests that arrive together as a group with one control file update. start_logger_task( )
+ * 		must have been called.
+ * @param file_name[in]
+ * 		Same as logger_insert( ). The name is copied. All handles to the file must stay closed until
+ * 		<b>done</b> is called.
+ * @param done
+ * 		Called from the writer task when the insert finished. May be NULL.
+ * @param arg
+ * 		Passed to <b>done</b>.
+ * @returns
+ * 		LOGGER_OK if queued, LOGGER_BUSY if the queue is full.
+ */
+logger_error_t logger_submit_insert( logger_t*, char const* file_name, logger_callback_t done, void* arg );
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Queue a record to be appended by the writer task.
+ * @details
+ * 		Returns immediately. The writer task appends the record as logger_append( ) would and flushes
+ * 		once per group of requests. start_logger_task( ) must have been called.
+ * @param buffer[in]
+ * 		The record. <b>Not copied</b>, it must stay valid until <b>done</b> is called.
+ * @param length
+ * 		Length of the record in bytes.
+ * @param done
+ * 		Called from the writer task when the record is on flash (or failed). May be NULL.
+ * @param arg
+ * 		Passed to <b>done</b>.
+ * @returns
+ * 		LOGGER_OK if queued, LOGGER_BUSY if the queue is full.
+ */
+logger_error_t logger_submit_append( logger_t*, void const* buffer, size_t length, logger_callback_t done, void* arg );
+
+/**
+ * @brief
+ * 		Create the writer task's queue and start the writer task.
+ */
 SAT_returnState start_logger_task(void);
+
+/**
+ * @brief
+ * 		The writer task. Waits for requests queued by logger_submit_insert( ) and logger_submit_append( ),
+ * 		takes up to LOGGER_WRITER_GROUP_SIZE of them at a time and commits each run for the same logger
+ * 		under one lock.
+ */
 void logger_task();
 
 
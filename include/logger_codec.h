@@ -0,0 +1,273 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_codec.h
+ * @date October 16, 2026
+ * @brief
+ * 		Block compression of data appended to a logger_t.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_CODEC_H_
+#define INCLUDE_TELEMETRY_LOGGER_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <logger.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Bytes compressed as one block. Blocks are independent, this is also the LZSS window. */
+#ifndef LOGGER_CODEC_BLOCK_SIZE
+#define LOGGER_CODEC_BLOCK_SIZE 512
+#endif
+
+/* | codec id (1 byte) | raw length (2 bytes) | packed length (2 bytes) | packed data | */
+#define LOGGER_CODEC_HEADER_LENGTH 5
+
+/* Codec ids. Blocks that don't shrink are stored as LOGGER_CODEC_STORED whatever the codec. */
+#define LOGGER_CODEC_STORED 0
+#define LOGGER_CODEC_LZSS 1
+
+/* LZSS match candidates tried per byte. More compresses better and slower. */
+#ifndef LOGGER_LZSS_CHAIN
+#define LOGGER_LZSS_CHAIN 16
+#endif
+#define LOGGER_LZSS_HASH_SIZE 256
+
+
+/********************************************************************************/
+/* Structure Documentation														*/
+/********************************************************************************/
+/**
+ * @struct logger_codec_t
+ * @brief
+ * 		A compression algorithm, see logger_compressor_t.
+ * @details
+ * 		Codecs work on one block of at most LOGGER_CODEC_BLOCK_SIZE bytes at a time and keep any
+ * 		working memory in their own structure, so an instance must only be used by one
+ * 		compressor or decompressor at a time.
+ * @var logger_codec_t::id
+ * 		Written with every block so the reader knows how to expand it. 1 to 255, 0 is
+ * 		LOGGER_CODEC_STORED.
+ * @var logger_codec_t::compress
+ * 		Pack <b>length</b> bytes from <b>in</b> into at most <b>size</b> bytes at <b>out</b>.
+ * 		Returns the packed length, or 0 if it doesn't fit.
+ * @var logger_codec_t::expand
+ * 		Unpack <b>length</b> bytes from <b>in</b> into at most <b>size</b> bytes at <b>out</b>.
+ * 		Returns the unpacked length, or 0 if the data is corrupt.
+ */
+typedef struct logger_codec_t logger_codec_t;
+
+/**
+ * @struct logger_lzss_t
+ * @brief
+ * 		LZSS codec with a fixed RAM window, in the style of heatshrink.
+ * @details
+ * 		Eight tokens share a flag byte. A literal is one byte, a match is two: a 12 bit distance and
+ * 		a 4 bit length (3 to 18 bytes). Matches are found through hash chains over the block,
+ * 		so the working memory is fixed at about 3 bytes per byte of block.
+ * @var logger_lzss_t::codec
+ * 		The codec, pass &logger_lzss_t::codec where a logger_codec_t is wanted.
+ * @var logger_lzss_t::head
+ * 		<b>Private</b>
+ * 		Latest position with each hash.
+ * @var logger_lzss_t::prev
+ * 		<b>Private</b>
+ * 		Previous position with the same hash, for each position.
+ */
+typedef struct logger_lzss_t logger_lzss_t;
+
+/**
+ * @struct logger_compressor_t
+ * @brief
+ * 		Compresses data on its way into a logger_t.
+ * @details
+ * 		Data is gathered into blocks of LOGGER_CODEC_BLOCK_SIZE bytes, each block is compressed and
+ * 		appended to the logger as one record:
+ * 		<br>| codec id (1 byte) | raw length (2 bytes) | packed length (2 bytes) | packed data |
+ * 		<br>Lengths are little endian. Blocks are independent, so an element can be expanded on its
+ * 		own and one lost to a reset costs only itself.
+ * @var logger_compressor_t::logger
+ * 		<b>Private</b>
+ * 		The logger written to.
+ * @var logger_compressor_t::codec
+ * 		<b>Private</b>
+ * 		The codec.
+ * @var logger_compressor_t::raw
+ * 		<b>Private</b>
+ * 		The block being gathered.
+ * @var logger_compressor_t::fill
+ * 		<b>Private</b>
+ * 		Bytes in logger_compressor_t::raw.
+ * @var logger_compressor_t::frame
+ * 		<b>Private</b>
+ * 		The block as it is appended.
+ * @var logger_compressor_t::raw_bytes
+ * 		Read only. Bytes given to the compressor so far.
+ * @var logger_compressor_t::packed_bytes
+ * 		Read only. Bytes appended to the logger for them, headers included.
+ * @var logger_compressor_t::blocks
+ * 		Read only. Blocks appended.
+ * @var logger_compressor_t::stored_blocks
+ * 		Read only. Blocks that didn't shrink and were stored as they were.
+ * @var logger_compressor_t::dropped_blocks
+ * 		Read only. Blocks lost because logger_append( ) failed, not counted in the other totals.
+ */
+typedef struct logger_compressor_t logger_compressor_t;
+
+/**
+ * @struct logger_decompressor_t
+ * @brief
+ * 		Reads the blocks logger_compressor_t wrote into an element.
+ * @var logger_decompressor_t::handle
+ * 		<b>Private</b>
+ * 		The element, owned by the caller.
+ * @var logger_decompressor_t::codec
+ * 		<b>Private</b>
+ * 		Codec for blocks that aren't stored.
+ * @var logger_decompressor_t::packed
+ * 		<b>Private</b>
+ * 		The block being read.
+ */
+typedef struct logger_decompressor_t logger_decompressor_t;
+
+
+/********************************************************************************/
+/* Structure Definition															*/
+/********************************************************************************/
+struct logger_codec_t
+{
+	uint8_t	id;
+	size_t	(*compress)( logger_codec_t*, uint8_t const* in, size_t length, uint8_t* out, size_t size );
+	size_t	(*expand)( logger_codec_t*, uint8_t const* in, size_t length, uint8_t* out, size_t size );
+};
+
+struct logger_lzss_t
+{
+	logger_codec_t	codec;
+	uint16_t		head[LOGGER_LZSS_HASH_SIZE];
+	uint16_t		prev[LOGGER_CODEC_BLOCK_SIZE];
+};
+
+struct logger_compressor_t
+{
+	logger_t*		logger;
+	logger_codec_t*	codec;
+	uint8_t			raw[LOGGER_CODEC_BLOCK_SIZE];
+	size_t			fill;
+	uint8_t			frame[LOGGER_CODEC_HEADER_LENGTH+LOGGER_CODEC_BLOCK_SIZE];
+	uint64_t		raw_bytes;
+	uint64_t		packed_bytes;
+	uint32_t		blocks;
+	uint32_t		stored_blocks;
+	uint32_t		dropped_blocks;
+};
+
+struct logger_decompressor_t
+{
+	int32_t			handle;
+	logger_codec_t*	codec;
+	uint8_t			packed[LOGGER_CODEC_BLOCK_SIZE];
+};
+
+
+/********************************************************************************/
+/* Method Declares																*/
+/********************************************************************************/
+/**
+ * @memberof logger_compressor_t
+ * @brief
+ * 		Compress data into the logger.
+ * @details
+ * 		A block is compressed and appended with logger_append( ) each time LOGGER_CODEC_BLOCK_SIZE
+ * 		bytes have been gathered. A block that fails to append is dropped, see
+ * 		logger_compressor_t::dropped_blocks, and the rest of the data is gathered anyway.
+ * @param data[in]
+ * 		The data.
+ * @param length
+ * 		Length of the data in bytes.
+ * @returns
+ * 		The first error appending a block, otherwise an error code. All of <b>data</b> is taken
+ * 		either way, writing it again would store it twice.
+ */
+logger_error_t logger_compressor_write( logger_compressor_t*, void const* data, size_t length );
+
+/**
+ * @memberof logger_compressor_t
+ * @brief
+ * 		Compress what has been gathered as a short block and flush the logger.
+ * @details
+ * 		Short blocks compress worse, call this when the data has to be on flash, for example
+ * 		before logger_rotate( ). The block is dropped if it fails to append.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_compressor_flush( logger_compressor_t* );
+
+/**
+ * @memberof logger_decompressor_t
+ * @brief
+ * 		Expand the next block.
+ * @param buffer[out]
+ * 		Where the data goes, LOGGER_CODEC_BLOCK_SIZE bytes always suffice.
+ * @param size
+ * 		Size of <b>buffer</b>.
+ * @param length[out]
+ * 		Bytes of data in the block.
+ * @returns
+ * 		LOGGER_EMPTY at the end of the element, LOGGER_INV_CAP if <b>buffer</b> is too small or
+ * 		the block needs a codec the decompressor doesn't have, LOGGER_NVMEM_ERR if the block
+ * 		is corrupt, otherwise an error code.
+ */
+logger_error_t logger_decompressor_read( logger_decompressor_t*, void* buffer, size_t size, size_t* length );
+
+
+/********************************************************************************/
+/* Initialization Method Declares												*/
+/********************************************************************************/
+/**
+ * @memberof logger_lzss_t
+ * @brief
+ * 		Initialize a logger_lzss_t structure.
+ * @returns
+ * 		&self->codec
+ */
+logger_codec_t* initialize_logger_lzss( logger_lzss_t *self );
+
+/**
+ * @memberof logger_compressor_t
+ * @brief
+ * 		Initialize a logger_compressor_t structure.
+ * @param logger
+ * 		Logger the blocks are appended to. Should only be appended to through this compressor.
+ * @param codec
+ * 		The codec. NULL stores blocks uncompressed.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t initialize_logger_compressor( logger_compressor_t *self, logger_t* logger, logger_codec_t* codec );
+
+/**
+ * @memberof logger_decompressor_t
+ * @brief
+ * 		Initialize a logger_decompressor_t structure.
+ * @param handle
+ * 		An open handle on the element, for example from logger_peek_at( ). Read from its current
+ * 		position, not closed by the decompressor.
+ * @param codec
+ * 		Codec of the blocks that aren't stored, may be NULL if all are.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t initialize_logger_decompressor( logger_decompressor_t *self, int32_t handle, logger_codec_t* codec );
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_CODEC_H_ */
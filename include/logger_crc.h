@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_crc.h
+ * @date October 16, 2026
+ * @brief
+ * 		CRC-32 used for logger control records, element checksums and read chunks.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_CRC_H_
+#define INCLUDE_TELEMETRY_LOGGER_CRC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Value to start a new CRC with. */
+#define LOGGER_CRC32_INIT 0
+
+
+/********************************************************************************/
+/* Function Declares															*/
+/********************************************************************************/
+/**
+ * @brief
+ * 		CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320).
+ * @details
+ * 		Can be computed in pieces, pass the result of the previous call as <b>crc</b>.
+ * 		The first call passes LOGGER_CRC32_INIT.
+ * 		<br>Slice by 8, eight bytes per table step using 8 KiB of tables. Define LOGGER_CRC32_SMALL
+ * 		for a 64 byte table at about a tenth of the speed.
+ * @param crc
+ * 		CRC of the data so far.
+ * @param data
+ * 		Next bytes to include.
+ * @param length
+ * 		Number of bytes in <b>data</b>.
+ * @returns
+ * 		CRC of everything so far, including <b>data</b>.
+ */
+uint32_t logger_crc32( uint32_t crc, void const* data, size_t length );
+
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_CRC_H_ */
@@ -0,0 +1,252 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_delta.h
+ * @date October 16, 2026
+ * @brief
+ * 		Delta and varint encoding of fixed layout samples into segment elements.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_DELTA_H_
+#define INCLUDE_TELEMETRY_LOGGER_DELTA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <logger_segment.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Most channels in a sample. */
+#ifndef LOGGER_DELTA_MAX_CHANNELS
+#define LOGGER_DELTA_MAX_CHANNELS 16
+#endif
+
+/* Longest varint, a 32 bit value. */
+#define LOGGER_DELTA_VARINT_MAX 5
+/* Largest encoded sample, its time and every channel. */
+#define LOGGER_DELTA_SAMPLE_MAX (LOGGER_DELTA_VARINT_MAX*(LOGGER_DELTA_MAX_CHANNELS+1))
+/* | sample count (1 byte) | samples | */
+#define LOGGER_DELTA_BLOCK_HEADER 1
+#define LOGGER_DELTA_MAX_INTERVAL 255
+
+
+/********************************************************************************/
+/* Structure Documentation														*/
+/********************************************************************************/
+/**
+ * @struct logger_delta_t
+ * @brief
+ * 		Encodes fixed layout samples as deltas into a logger_segment_t.
+ * @details
+ * 		A sample is a time stamp and a fixed number of signed 32 bit channels. Samples are gathered into
+ * 		blocks, each written as one segment record stamped with the time of its first sample:
+ * 		<br>| sample count (1 byte) | keyframe | delta | delta | ...
+ * 		<br>The keyframe is the first sample with every channel as a zig-zag varint. Each delta
+ * 		that follows is the time since the previous sample as a varint, then every channel's
+ * 		change since the previous sample as a zig-zag varint. A slowly changing channel
+ * 		costs one byte a sample.
+ * 		<br>A block starts with a keyframe, so reading can begin at any record, see
+ * 		logger_delta_reader_seek( ).
+ * @var logger_delta_t::segment
+ * 		<b>Private</b>
+ * 		Segment the blocks are written to.
+ * @var logger_delta_t::channels
+ * 		<b>Private</b>
+ * 		Channels in a sample.
+ * @var logger_delta_t::interval
+ * 		<b>Private</b>
+ * 		Most samples in a block, so samples between keyframes plus one.
+ * @var logger_delta_t::count
+ * 		<b>Private</b>
+ * 		Samples in the open block, 0 when there is none.
+ * @var logger_delta_t::first
+ * 		<b>Private</b>
+ * 		Time of the open block's keyframe.
+ * @var logger_delta_t::timestamp
+ * 		<b>Private</b>
+ * 		Time of the last sample.
+ * @var logger_delta_t::last
+ * 		<b>Private</b>
+ * 		Channels of the last sample.
+ * @var logger_delta_t::length
+ * 		<b>Private</b>
+ * 		Bytes in logger_delta_t::block.
+ * @var logger_delta_t::block
+ * 		<b>Private</b>
+ * 		The open block.
+ * @var logger_delta_t::raw_bytes
+ * 		Read only. Bytes the samples written so far take unencoded, 4 per channel and time stamp.
+ * @var logger_delta_t::packed_bytes
+ * 		Read only. Bytes of blocks written for them, without the segment's framing.
+ */
+typedef struct logger_delta_t logger_delta_t;
+
+/**
+ * @struct logger_delta_reader_t
+ * @brief
+ * 		Decodes the samples logger_delta_t wrote to one segment.
+ * @var logger_delta_reader_t::segment
+ * 		<b>Private</b>
+ * 		Reader on the segment, opened by the caller.
+ * @var logger_delta_reader_t::channels
+ * 		<b>Private</b>
+ * 		Channels in a sample.
+ * @var logger_delta_reader_t::remaining
+ * 		<b>Private</b>
+ * 		Samples left in logger_delta_reader_t::block.
+ * @var logger_delta_reader_t::keyframe
+ * 		<b>Private</b>
+ * 		Set if the next sample is a keyframe.
+ * @var logger_delta_reader_t::timestamp
+ * 		<b>Private</b>
+ * 		Time of the last sample read.
+ * @var logger_delta_reader_t::last
+ * 		<b>Private</b>
+ * 		Channels of the last sample read.
+ * @var logger_delta_reader_t::length
+ * 		<b>Private</b>
+ * 		Bytes in logger_delta_reader_t::block.
+ * @var logger_delta_reader_t::position
+ * 		<b>Private</b>
+ * 		Next byte to decode in logger_delta_reader_t::block.
+ * @var logger_delta_reader_t::block
+ * 		<b>Private</b>
+ * 		The block being read.
+ */
+typedef struct logger_delta_reader_t logger_delta_reader_t;
+
+
+/********************************************************************************/
+/* Structure Definition															*/
+/********************************************************************************/
+struct logger_delta_t
+{
+	logger_segment_t*	segment;
+	uint8_t				channels;
+	uint8_t				interval;
+	uint8_t				count;
+	uint32_t			first;
+	uint32_t			timestamp;
+	int32_t				last[LOGGER_DELTA_MAX_CHANNELS];
+	size_t				length;
+	uint8_t				block[LOGGER_SEGMENT_MAX_RECORD];
+	uint64_t			raw_bytes;
+	uint64_t			packed_bytes;
+};
+
+struct logger_delta_reader_t
+{
+	logger_segment_reader_t*	segment;
+	uint8_t						channels;
+	uint8_t						remaining;
+	bool_t						keyframe;
+	uint32_t					timestamp;
+	int32_t						last[LOGGER_DELTA_MAX_CHANNELS];
+	size_t						length;
+	size_t						position;
+	uint8_t						block[LOGGER_SEGMENT_MAX_RECORD];
+};
+
+
+/********************************************************************************/
+/* Method Declares																*/
+/********************************************************************************/
+/**
+ * @memberof logger_delta_t
+ * @brief
+ * 		Encode a sample.
+ * @details
+ * 		The open block is written to the segment first if it holds logger_delta_t::interval samples
+ * 		or the sample may not fit.
+ * @param timestamp
+ * 		Time of the sample. Must not go backwards.
+ * @param values[in]
+ * 		The channels.
+ * @returns
+ * 		LOGGER_INV_CAP if <b>timestamp</b> goes backwards, otherwise an error code.
+ */
+logger_error_t logger_delta_write( logger_delta_t*, uint32_t timestamp, int32_t const* values );
+
+/**
+ * @memberof logger_delta_t
+ * @brief
+ * 		Write the open block to the segment, the next sample starts a new one with a keyframe.
+ * @details
+ * 		Does not close or flush the segment.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_delta_flush( logger_delta_t* );
+
+/**
+ * @memberof logger_delta_reader_t
+ * @brief
+ * 		Position the reader at the keyframe nearest before <b>timestamp</b>.
+ * @details
+ * 		Reading goes on from the last block that starts at or before <b>timestamp</b>, or the first
+ * 		block if they all start after it. Costs one logger_segment_find( ), segments without a
+ * 		footer are walked twice, once to find the block and once to seek to it.
+ * @returns
+ * 		LOGGER_EMPTY if the segment has no blocks, otherwise an error code.
+ */
+logger_error_t logger_delta_reader_seek( logger_delta_reader_t*, uint32_t timestamp );
+
+/**
+ * @memberof logger_delta_reader_t
+ * @brief
+ * 		Decode the next sample.
+ * @param timestamp[out]
+ * 		Time of the sample.
+ * @param values[out]
+ * 		The channels, room for as many as the reader was initialized with.
+ * @returns
+ * 		LOGGER_EMPTY past the last sample, LOGGER_NVMEM_ERR if a block is corrupt, otherwise an
+ * 		error code.
+ */
+logger_error_t logger_delta_reader_read( logger_delta_reader_t*, uint32_t* timestamp, int32_t* values );
+
+
+/********************************************************************************/
+/* Initialization Method Declares												*/
+/********************************************************************************/
+/**
+ * @memberof logger_delta_t
+ * @brief
+ * 		Initialize a logger_delta_t structure.
+ * @param segment
+ * 		The segment written to. Nothing else should write records to it.
+ * @param channels
+ * 		Channels in a sample, 1 to LOGGER_DELTA_MAX_CHANNELS.
+ * @param interval
+ * 		Samples per keyframe, 1 to LOGGER_DELTA_MAX_INTERVAL. Longer intervals encode better,
+ * 		shorter ones make logger_delta_reader_seek( ) land closer.
+ * @returns
+ * 		LOGGER_INV_CAP if <b>channels</b> or <b>interval</b> is out of range, otherwise an error code.
+ */
+logger_error_t initialize_logger_delta( logger_delta_t *self, logger_segment_t* segment, uint8_t channels, uint8_t interval );
+
+/**
+ * @memberof logger_delta_reader_t
+ * @brief
+ * 		Initialize a logger_delta_reader_t structure.
+ * @details
+ * 		Reading starts at the segment reader's position, which must be the start of a block.
+ * @param segment
+ * 		An open reader on the segment, see logger_segment_reader_open( ).
+ * @param channels
+ * 		Channels in a sample, as the segment was written with.
+ * @returns
+ * 		LOGGER_INV_CAP if <b>channels</b> is out of range, otherwise an error code.
+ */
+logger_error_t initialize_logger_delta_reader( logger_delta_reader_t *self, logger_segment_reader_t* segment, uint8_t channels );
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_DELTA_H_ */
@@ -0,0 +1,51 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_endian.h
+ * @date October 16, 2026
+ * @brief
+ * 		Little endian fields of the records the logger modules write to flash.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_ENDIAN_H_
+#define INCLUDE_TELEMETRY_LOGGER_ENDIAN_H_
+
+#include <stdint.h>
+
+/********************************************************************************/
+/* Function Definitions															*/
+/********************************************************************************/
+/* Little endian, so what is on flash doesn't depend on the target. */
+static inline void logger_put_u16( uint8_t* at, uint16_t value )
+{
+	at[0] = (uint8_t) value;
+	at[1] = (uint8_t) (value >> 8);
+}
+
+static inline uint16_t logger_get_u16( uint8_t const* at )
+{
+	return (uint16_t) (at[0] | (at[1] << 8));
+}
+
+static inline void logger_put_u32( uint8_t* at, uint32_t value )
+{
+	at[0] = (uint8_t) value;
+	at[1] = (uint8_t) (value >> 8);
+	at[2] = (uint8_t) (value >> 16);
+	at[3] = (uint8_t) (value >> 24);
+}
+
+static inline uint32_t logger_get_u32( uint8_t const* at )
+{
+	return (uint32_t) at[0] | ((uint32_t) at[1] << 8) | ((uint32_t) at[2] << 16) | ((uint32_t) at[3] << 24);
+}
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_ENDIAN_H_ */
@@ -0,0 +1,161 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_fifo.h
+ * @date October 16, 2026
+ * @brief
+ * 		Lock free ring that queues records from an ISR for a logger_t.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_FIFO_H_
+#define INCLUDE_TELEMETRY_LOGGER_FIFO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <logger.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Every record is preceded by its length. */
+#define LOGGER_FIFO_HEADER_BYTES 2
+
+/* Largest record logger_fifo_push( ) accepts. */
+#ifndef LOGGER_FIFO_MAX_RECORD
+#define LOGGER_FIFO_MAX_RECORD 256
+#endif
+
+
+/********************************************************************************/
+/* Structure Documentation														*/
+/********************************************************************************/
+/**
+ * @struct logger_fifo_t
+ * @brief
+ * 		Lock free RAM ring of framed records in front of a logger_t.
+ * @details
+ * 		One producer, which may be an ISR, pushes records with logger_fifo_push( ). It never blocks
+ * 		and never takes a mutex, if there is no room, or the record is longer than LOGGER_FIFO_MAX_RECORD,
+ * 		the record is dropped and counted as an overrun.
+ * 		One consumer, normally a low priority task, moves the records into a logger_t with
+ * 		logger_fifo_drain( ).
+ * 		<br>Each side only writes its own index, so no lock is needed between them. Using more
+ * 		than one producer or more than one consumer requires external locking.
+ * @var logger_fifo_t::buffer
+ * 		<b>Private</b>
+ * 		Storage for framed records, provided by the application.
+ * @var logger_fifo_t::mask
+ * 		<b>Private</b>
+ * 		Size of logger_fifo_t::buffer minus one. The size is a power of two.
+ * @var logger_fifo_t::head
+ * 		<b>Private</b>
+ * 		Free running write index, only written by the producer.
+ * @var logger_fifo_t::tail
+ * 		<b>Private</b>
+ * 		Free running read index, only written by the consumer.
+ * @var logger_fifo_t::overruns
+ * 		<b>Private</b>
+ * 		Number of records dropped because the ring was full or they were too long. Only written by
+ * 		the producer.
+ */
+typedef struct logger_fifo_t logger_fifo_t;
+
+
+/********************************************************************************/
+/* Structure Definition															*/
+/********************************************************************************/
+struct logger_fifo_t
+{
+	uint8_t				*buffer;
+	uint32_t			mask;
+	volatile uint32_t	head;
+	volatile uint32_t	tail;
+	volatile uint32_t	overruns;
+};
+
+
+/********************************************************************************/
+/* Method Declares																*/
+/********************************************************************************/
+/**
+ * @memberof logger_fifo_t
+ * @brief
+ * 		Push a record. Safe to call from an ISR.
+ * @details
+ * 		Constant time, the cost is two copies of at most <b>length</b> bytes.
+ * @param record[in]
+ * 		The record.
+ * @param length
+ * 		Length of the record in bytes, 1 to LOGGER_FIFO_MAX_RECORD.
+ * @returns
+ * 		true if the record was queued, false if it was dropped. An empty record is refused without
+ * 		counting as an overrun.
+ */
+bool_t logger_fifo_push( logger_fifo_t*, void const* record, uint16_t length );
+
+/**
+ * @memberof logger_fifo_t
+ * @brief
+ * 		Pop a record.
+ * @param record[out]
+ * 		The record is copied into here.
+ * @param max_length
+ * 		Size of <b>record</b>. A record longer than this is discarded, LOGGER_FIFO_MAX_RECORD bytes
+ * 		always suffice.
+ * @returns
+ * 		The length of the record, 0 if there was no record to pop (or it was discarded).
+ */
+size_t logger_fifo_pop( logger_fifo_t*, void* record, size_t max_length );
+
+/**
+ * @memberof logger_fifo_t
+ * @brief
+ * 		Move records into a logger.
+ * @details
+ * 		Each record is added with logger_append( ), in the order it was pushed. Must be called from
+ * 		the one consumer task, never from an ISR.
+ * @param logger
+ * 		The logger the records go into.
+ * @param max_records
+ * 		The most records to move in this call, 0 for no limit.
+ * @param drained[out]
+ * 		The number of records moved. Pass as NULL to ignore it.
+ * @returns
+ * 		An error code from logger_append( ). The record that failed is dropped rather than tried
+ * 		again, since part of it may have been written. Records after it are left in the ring.
+ */
+logger_error_t logger_fifo_drain( logger_fifo_t*, logger_t* logger, size_t max_records, size_t* drained );
+
+/**
+ * @memberof logger_fifo_t
+ * @brief
+ * 		Number of records dropped because the ring was full or they were too long.
+ */
+uint32_t logger_fifo_overruns( logger_fifo_t const* );
+
+
+/********************************************************************************/
+/* Initialization Method Declares												*/
+/********************************************************************************/
+/**
+ * @memberof logger_fifo_t
+ * @brief
+ * 		Initialize a logger_fifo_t structure.
+ * @param storage
+ * 		Memory for the ring. Must remain valid for as long as the ring is used.
+ * @param size
+ * 		Size of <b>storage</b> in bytes. Must be a power of two larger than LOGGER_FIFO_HEADER_BYTES.
+ * @returns
+ * 		LOGGER_INV_CAP if <b>size</b> is not valid, otherwise LOGGER_OK.
+ */
+logger_error_t initialize_logger_fifo( logger_fifo_t *self, uint8_t* storage, size_t size );
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_FIFO_H_ */
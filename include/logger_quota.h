@@ -0,0 +1,168 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_quota.h
+ * @date October 16, 2026
+ * @brief
+ * 		Storage budget shared by several logger_t instances.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_QUOTA_H_
+#define INCLUDE_TELEMETRY_LOGGER_QUOTA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <logger.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Most loggers one logger_quota_t can share its budget between. */
+#ifndef LOGGER_QUOTA_MAX_LOGGERS
+#define LOGGER_QUOTA_MAX_LOGGERS 8
+#endif
+
+
+/********************************************************************************/
+/* Structure Documentation														*/
+/********************************************************************************/
+/**
+ * @struct logger_quota_t
+ * @brief
+ * 		One storage budget shared by several logger_t.
+ * @details
+ * 		Each registered logger may use as much of the budget as is free. Once the loggers together
+ * 		go over the budget, the oldest element of the logger furthest over its weighted share is
+ * 		deleted, until they fit again. A logger that is idle therefore costs the others nothing,
+ * 		and a busy one only loses data to its own weight.
+ * 		<br>Accounting is done in RAM by each logger, see logger_set_quota( ). A registered logger also
+ * 		adds what it stores to logger_quota_t::used, in a short critical section. Only once that
+ * 		total is over the budget does the logger enforce it, after releasing its own mutex, so
+ * 		writes within the budget take no lock but their own logger's. The budget's mutex is always
+ * 		taken before a logger's, never the other way around.
+ * @var logger_quota_t::budget
+ * 		<b>Private</b>
+ * 		Bytes all registered loggers may use together.
+ * @var logger_quota_t::loggers
+ * 		<b>Private</b>
+ * 		Registered loggers.
+ * @var logger_quota_t::weights
+ * 		<b>Private</b>
+ * 		Share of the budget of each registered logger, relative to the others.
+ * @var logger_quota_t::count
+ * 		<b>Private</b>
+ * 		Number of registered loggers.
+ * @var logger_quota_t::used
+ * 		<b>Private</b>
+ * 		Bytes stored by all registered loggers together, kept by the loggers as they store and
+ * 		remove data. Only accessed in critical sections.
+ * @var logger_quota_t::mutex
+ * 		<b>Private</b>
+ * 		Serializes enforcement and registration.
+ */
+typedef struct logger_quota_t logger_quota_t;
+
+
+/********************************************************************************/
+/* Structure Definition															*/
+/********************************************************************************/
+struct logger_quota_t
+{
+	uint64_t			budget;
+	logger_t*			loggers[LOGGER_QUOTA_MAX_LOGGERS];
+	uint8_t				weights[LOGGER_QUOTA_MAX_LOGGERS];
+	size_t				count;
+	uint64_t			used;
+	SemaphoreHandle_t	mutex;
+};
+
+
+/********************************************************************************/
+/* Method Declares																*/
+/********************************************************************************/
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Share the budget with a logger.
+ * @details
+ * 		Turns on byte accounting in <b>logger</b> if it has no quota of its own. A logger can only be
+ * 		registered with one logger_quota_t. logger_t::destroy unregisters it.
+ * @param logger
+ * 		The logger.
+ * @param weight
+ * 		Relative share of the budget, 1 to 255. A logger with weight 2 is only evicted from once it
+ * 		holds twice as many bytes as a logger with weight 1.
+ * @returns
+ * 		LOGGER_TABLE_FULL if LOGGER_QUOTA_MAX_LOGGERS are already registered, LOGGER_INV_CAP if
+ * 		<b>weight</b> is 0 or the logger is already registered with this or another logger_quota_t,
+ * 		otherwise an error code from logger_set_quota( ) or logger_quota_enforce( ).
+ */
+logger_error_t logger_quota_register( logger_quota_t*, logger_t* logger, uint8_t weight );
+
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Stop sharing the budget with a logger.
+ */
+void logger_quota_unregister( logger_quota_t*, logger_t* logger );
+
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Evict until the registered loggers fit in the budget.
+ * @details
+ * 		Called by registered loggers, there is normally no need to call this. Must not be called
+ * 		while holding a registered logger's mutex.
+ * @returns
+ * 		LOGGER_NVMEM_FULL if every logger is down to its HEAD and the budget is still exceeded,
+ * 		otherwise an error code.
+ */
+logger_error_t logger_quota_enforce( logger_quota_t* );
+
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Bytes used by all registered loggers together.
+ */
+uint64_t logger_quota_used( logger_quota_t* );
+
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Add to, or with a negative <b>bytes</b> take from, the bytes stored by registered loggers.
+ * @details
+ * 		Called by registered loggers as their count changes, never takes a mutex.
+ */
+void logger_quota_count( logger_quota_t*, int64_t bytes );
+
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Check if the registered loggers are over the budget, never takes a mutex.
+ */
+bool_t logger_quota_exceeded( logger_quota_t* );
+
+
+/********************************************************************************/
+/* Initialization Method Declares												*/
+/********************************************************************************/
+/**
+ * @memberof logger_quota_t
+ * @brief
+ * 		Initialize a logger_quota_t structure.
+ * @param budget
+ * 		Bytes all registered loggers may use together.
+ * @returns
+ * 		LOGGER_MUTEX_ERR if the mutex could not be created, otherwise LOGGER_OK.
+ */
+logger_error_t initialize_logger_quota( logger_quota_t *self, uint64_t budget );
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_QUOTA_H_ */
@@ -0,0 +1,265 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_segment.h
+ * @date October 16, 2026
+ * @brief
+ * 		Segment elements, many time stamped records in one element with a footer index.
+ */
+#ifndef INCLUDE_TELEMETRY_LOGGER_SEGMENT_H_
+#define INCLUDE_TELEMETRY_LOGGER_SEGMENT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <logger.h>
+
+/********************************************************************************/
+/* Defines																		*/
+/********************************************************************************/
+/* Most records in one segment, each costs LOGGER_SEGMENT_INDEX_ENTRY bytes of RAM in the writer. */
+#ifndef LOGGER_SEGMENT_MAX_RECORDS
+#define LOGGER_SEGMENT_MAX_RECORDS 128
+#endif
+/* Largest record payload. */
+#ifndef LOGGER_SEGMENT_MAX_RECORD
+#define LOGGER_SEGMENT_MAX_RECORD 256
+#endif
+
+/* | length (2 bytes) | timestamp (4 bytes) | payload | crc32 (4 bytes) | */
+#define LOGGER_SEGMENT_HEADER_LENGTH 6
+#define LOGGER_SEGMENT_FRAME_OVERHEAD (LOGGER_SEGMENT_HEADER_LENGTH+4)
+/* | offset (4 bytes) | timestamp (4 bytes) | */
+#define LOGGER_SEGMENT_INDEX_ENTRY 8
+/* | record count (4 bytes) | crc32 of index and count (4 bytes) | magic (4 bytes) | */
+#define LOGGER_SEGMENT_TRAILER_LENGTH 12
+#define LOGGER_SEGMENT_MAGIC 0x4745534CUL /* "LSEG" */
+
+
+/********************************************************************************/
+/* Structure Documentation														*/
+/********************************************************************************/
+/**
+ * @struct logger_segment_t
+ * @brief
+ * 		Packs many small records into each element of a logger_t.
+ * @details
+ * 		A segment is one element holding framed records:
+ * 		<br>| length (2 bytes) | timestamp (4 bytes) | payload | crc32 (4 bytes) | ...
+ * 		<br>followed, once the segment is closed, by a footer indexing them:
+ * 		<br>| offset (4 bytes) | timestamp (4 bytes) | ... | record count (4 bytes) | crc32 (4 bytes) | "LSEG" (4 bytes) |
+ * 		<br>All numbers are little endian. Records go through the logger's append path, so a
+ * 		sample costs a memcpy into the append buffer instead of an insert; the element is only
+ * 		renamed, and the control data only written, once per segment.
+ * 		<br>The writer keeps the index in RAM until the segment is closed. A segment cut short by a
+ * 		reset has no footer, logger_segment_reader_t then falls back to walking the frames.
+ * @var logger_segment_t::logger
+ * 		<b>Private</b>
+ * 		The logger written to. Nothing else may append to it.
+ * @var logger_segment_t::cursor
+ * 		<b>Private</b>
+ * 		Append cursor on the logger's HEAD.
+ * @var logger_segment_t::max_bytes
+ * 		<b>Private</b>
+ * 		Segments are closed before they grow past this, footer included. 0 for no limit.
+ * @var logger_segment_t::length
+ * 		<b>Private</b>
+ * 		Bytes of records in the open segment.
+ * @var logger_segment_t::count
+ * 		<b>Private</b>
+ * 		Records in the open segment, 0 when there is none.
+ * @var logger_segment_t::frame
+ * 		<b>Private</b>
+ * 		A record is framed here so it is appended in one piece.
+ * @var logger_segment_t::index
+ * 		<b>Private</b>
+ * 		Footer of the open segment, as it will be written.
+ */
+typedef struct logger_segment_t logger_segment_t;
+
+/**
+ * @struct logger_segment_reader_t
+ * @brief
+ * 		Finds records in one segment, see logger_segment_reader_open( ).
+ * @var logger_segment_reader_t::handle
+ * 		<b>Private</b>
+ * 		The segment file, owned by the caller.
+ * @var logger_segment_reader_t::indexed
+ * 		<b>Private</b>
+ * 		Set if the segment has a valid footer.
+ * @var logger_segment_reader_t::count
+ * 		<b>Private</b>
+ * 		Records in the segment, only known if logger_segment_reader_t::indexed is set.
+ * @var logger_segment_reader_t::end
+ * 		<b>Private</b>
+ * 		Offset where the records end, the footer or the end of the file.
+ * @var logger_segment_reader_t::position
+ * 		<b>Private</b>
+ * 		Offset of the next record logger_segment_read( ) returns.
+ */
+typedef struct logger_segment_reader_t logger_segment_reader_t;
+
+
+/********************************************************************************/
+/* Structure Definition															*/
+/********************************************************************************/
+struct logger_segment_t
+{
+	logger_t*			logger;
+	logger_cursor_t		cursor;
+	size_t				max_bytes;
+	size_t				length;
+	uint32_t			count;
+	uint8_t				frame[LOGGER_SEGMENT_MAX_RECORD+LOGGER_SEGMENT_FRAME_OVERHEAD];
+	uint8_t				index[LOGGER_SEGMENT_MAX_RECORDS*LOGGER_SEGMENT_INDEX_ENTRY+LOGGER_SEGMENT_TRAILER_LENGTH];
+};
+
+struct logger_segment_reader_t
+{
+	int32_t				handle;
+	bool_t				indexed;
+	uint32_t			count;
+	uint32_t			end;
+	uint32_t			position;
+};
+
+
+/********************************************************************************/
+/* Writer Method Declares														*/
+/********************************************************************************/
+/**
+ * @memberof logger_segment_t
+ * @brief
+ * 		Append a record to the open segment.
+ * @details
+ * 		Starts a new segment in a new element if there is none open, and closes the open one first if
+ * 		the record would not fit.
+ * @param timestamp
+ * 		Time of the record, used by logger_segment_find( ). Should not go backwards.
+ * @param data[in]
+ * 		The record.
+ * @param length
+ * 		Length of the record, at most LOGGER_SEGMENT_MAX_RECORD bytes.
+ * @returns
+ * 		LOGGER_INV_CAP if the record is too long, otherwise an error code.
+ */
+logger_error_t logger_segment_write( logger_segment_t*, uint32_t timestamp, void const* data, size_t length );
+
+/**
+ * @memberof logger_segment_t
+ * @brief
+ * 		Write the footer of the open segment and close its element.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_segment_close( logger_segment_t* );
+
+/**
+ * @memberof logger_segment_t
+ * @brief
+ * 		Write the records staged by the logger, the segment stays open.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t logger_segment_flush( logger_segment_t* );
+
+
+/********************************************************************************/
+/* Reader Method Declares														*/
+/********************************************************************************/
+/**
+ * @memberof logger_segment_reader_t
+ * @brief
+ * 		Start reading a segment.
+ * @details
+ * 		Reads and checks the footer. The reader is positioned at the first record.
+ * @param handle
+ * 		An open handle on the segment, for example from logger_peek_at( ). Not closed by the reader.
+ * @returns
+ * 		An error code. A segment without a valid footer can still be read.
+ */
+logger_error_t logger_segment_reader_open( logger_segment_reader_t*, int32_t handle );
+
+/**
+ * @memberof logger_segment_reader_t
+ * @brief
+ * 		Position the reader at record <b>k</b>.
+ * @details
+ * 		One read of the footer. Segments without a footer are walked frame by frame.
+ * @returns
+ * 		LOGGER_EMPTY if there is no record <b>k</b>, otherwise an error code.
+ */
+logger_error_t logger_segment_seek( logger_segment_reader_t*, uint32_t k );
+
+/**
+ * @memberof logger_segment_reader_t
+ * @brief
+ * 		Position the reader at the first record stamped at or after <b>timestamp</b>.
+ * @details
+ * 		Binary searches the footer, reading O(log n) entries. Segments without a footer are walked
+ * 		frame by frame.
+ * @param k[out]
+ * 		Number of the record, or of records in the segment if every record is older. May be NULL.
+ * @returns
+ * 		LOGGER_EMPTY if every record is older, otherwise an error code.
+ */
+logger_error_t logger_segment_find( logger_segment_reader_t*, uint32_t timestamp, uint32_t* k );
+
+/**
+ * @memberof logger_segment_reader_t
+ * @brief
+ * 		Read the record at the reader's position and move to the next one.
+ * @param buffer[out]
+ * 		Where the record is copied.
+ * @param size
+ * 		Size of <b>buffer</b>.
+ * @param length[out]
+ * 		Length of the record.
+ * @param timestamp[out]
+ * 		Time stamp of the record, may be NULL.
+ * @returns
+ * 		LOGGER_EMPTY past the last record, LOGGER_INV_CAP if <b>buffer</b> is too small,
+ * 		LOGGER_NVMEM_ERR if the record is corrupt, otherwise an error code.
+ */
+logger_error_t logger_segment_read( logger_segment_reader_t*, void* buffer, size_t size, size_t* length, uint32_t* timestamp );
+
+/**
+ * @memberof logger_segment_reader_t
+ * @brief
+ * 		Records in the segment.
+ * @details
+ * 		Kept from the footer. Segments without a footer are walked frame by frame.
+ */
+uint32_t logger_segment_count( logger_segment_reader_t* );
+
+
+/********************************************************************************/
+/* Initialization Method Declares												*/
+/********************************************************************************/
+/**
+ * @memberof logger_segment_t
+ * @brief
+ * 		Initialize a logger_segment_t structure.
+ * @details
+ * 		The segment takes over rotation of <b>logger</b>, logger_set_rotation( ) is reset so elements
+ * 		only end with a segment. No file is touched until the first record.
+ * @param logger
+ * 		The logger the segments are elements of. Must not be appended to or inserted into by anything
+ * 		else while the segment is in use.
+ * @param max_bytes
+ * 		Size segments are closed at, footer included. 0 to close them only when
+ * 		LOGGER_SEGMENT_MAX_RECORDS is reached.
+ * @returns
+ * 		An error code.
+ */
+logger_error_t initialize_logger_segment( logger_segment_t *self, logger_t* logger, size_t max_bytes );
+
+#endif /* INCLUDE_TELEMETRY_LOGGER_SEGMENT_H_ */
@@ -24,29 +24,99 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <logger.h>
+#include <logger_crc.h>
+#include <logger_endian.h>
+#include <logger_quota.h>
 #include "util/service_utilities.h"
 
 /********************************************************************************/
 /* Defines																		*/
 /********************************************************************************/
+/* Legacy (text) control file, only read to migrate it. */
 #define LOGGER_META_HEAD_START 0
 #define	LOGGER_META_TAIL_START (FILESYSTEM_MAX_NAME_LENGTH+1)
 #define LOGGER_CONTROL_DATA_LENGTH ((2*(FILESYSTEM_MAX_NAME_LENGTH+1))+3+4+7+2)
 #define LOGGER_META_TEM_START ((2*(FILESYSTEM_MAX_NAME_LENGTH+1))+3+4)
-#define LOGGER_META_TEM_LENGTH 7
+#define LOGGER_META_TEM_LENGTH LOGGER_TOTAL_POPPED_BYTES
+
+/* Control file, two alternating binary records. See logger_write_control( ). */
+#define LOGGER_CONTROL_MAGIC 0x43474F4CUL /* "LOGC" */
+#define LOGGER_CONTROL_FIELDS 8
+#define LOGGER_CONTROL_RECORD_LENGTH (LOGGER_CONTROL_FIELDS*4)
+#define LOGGER_CONTROL_SLOTS 2
+#define LOGGER_CONTROL_FILE_LENGTH (LOGGER_CONTROL_SLOTS*LOGGER_CONTROL_RECORD_LENGTH)
+
+/* Metadata journal, see logger_set_journal( ). */
+#define LOGGER_JOURNAL_HEAD 1
+#define LOGGER_JOURNAL_TAIL 2
+#define LOGGER_JOURNAL_POPPED 3
+#define LOGGER_JOURNAL_RECORD_LENGTH 12
+/* Records read per red_read( ) during replay. */
+#define LOGGER_JOURNAL_READ_RECORDS 16
+/* Time index, see logger_set_time_source( ). A record of zeros never matches. */
+#define LOGGER_INDEX_KEY 0x58444954UL /* "TIDX" */
+#define LOGGER_INDEX_RECORD_LENGTH 8
+
+/* Element checksums, see logger_set_checksums( ). */
+#define LOGGER_CHECKSUM_KEY 0x4D555343UL /* "CSUM" */
+#define LOGGER_CHECKSUM_RECORD_LENGTH 12
+#define LOGGER_CHECKSUM_READ_LENGTH 128
+#define LOGGER_MAX_POPPED_POINTS (10*10*10*10*10*10*10)
 
 /*Some pending defines regarding io func*/
 #define FILE_WRITE_ERR 0
 #define FILE_READ_ERR 0
 #define FILE_SEEK_SUCCESS 0
 #define GET_NULL_FILE NULL
-#define RED_FILE_ERR -1
+
+#define LOGGER_REQUEST_INSERT 0
+#define LOGGER_REQUEST_APPEND 1
+#define LOGGER_REQUEST_SWEEP 2
+#define LOGGER_REQUEST_REFILL 3
+
+/* Attempts at a lock free read of the cached control data before falling back to the mutex. */
+#define LOGGER_READ_RETRIES 3
+
+#define LOGGER_ELEMENT_EXTENSION ".log"
+#define LOGGER_POPPED_EXTENSION ".bin"
+
+/********************************************************************************/
+/* Name Formatting Tables														*/
+/********************************************************************************/
+static char const logger_hex_digits[] = "0123456789abcdef";
+static char const logger_base32_digits[] = "0123456789abcdefghijklmnopqrstuv";
+
+/* "00" through "99", two characters each. */
+static char const logger_decimal_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/********************************************************************************/
+/* Private Types																*/
+/********************************************************************************/
+/* One insert or append, or upkeep for a logger, for the writer task. */
+typedef struct
+{
+	logger_t*			logger;
+	uint8_t				op;
+	char				file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	void const*			buffer;
+	size_t				length;
+	logger_callback_t	done;
+	void*				arg;
+} logger_request_t;
 
 /********************************************************************************/
 /* Singletons																	*/
 /********************************************************************************/
-/* All logger instance share the same mutex. */
-static SemaphoreHandle_t logger_sync_mutex;
+/* Each logger instance has its own mutex. This one only guards state shared by all */
+/* instances (the element name registry below) and is held very briefly. */
+static SemaphoreHandle_t logger_fs_mutex;
+
+/* Bit set for each element file name in use by an initialized logger. Two loggers with */
+/* the same element name would track each other's files. */
+static uint32_t logger_element_names[256/32];
+
+/* Requests for the writer task, see logger_task( ). */
+static QueueHandle_t logger_writer_queue;
 
 /********************************************************************************/
 /* Private Method Definitions													*/
@@ -61,6 +131,56 @@ static inline void unlock_mutex(SemaphoreHandle_t mutex){
     xSemaphoreGive(mutex);
 }
 
+/* Readers of the cached HEAD / TAIL names don't take the mutex. Writers, which always */
+/* hold the mutex, make logger_t::control_version odd while they change the cache. A reader */
+/* retries if the version was odd or changed while it copied a name. */
+static inline void logger_write_begin( logger_t* self )
+{
+	++self->control_version;
+	LOGGER_MEMORY_BARRIER();
+}
+
+static inline void logger_write_end( logger_t* self )
+{
+	LOGGER_MEMORY_BARRIER();
+	++self->control_version;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Copy a cached name without taking the mutex.
+ * @details
+ * 		Gives up after LOGGER_READ_RETRIES attempts (for example, when a lower priority writer was
+ * 		preempted half way through an update), the caller must then take the mutex.
+ * @param name[in]
+ * 		logger_t::head_file_name or logger_t::tail_file_name.
+ * @param copy[out]
+ * 		Must point to at least FILESYSTEM_MAX_NAME_LENGTH+1 bytes.
+ * @returns
+ * 		true if <b>copy</b> holds a consistent name.
+ */
+static bool_t logger_read_name( logger_t* self, char const* name, char* copy )
+{
+	uint32_t	version;
+	unsigned int i;
+
+	for( i = 0; i < LOGGER_READ_RETRIES; ++i ) {
+		version = self->control_version;
+		LOGGER_MEMORY_BARRIER();
+		if( (version & 1) || !self->control_data_cached ) {
+			continue;
+		}
+		memcpy(copy, name, FILESYSTEM_MAX_NAME_LENGTH);
+		copy[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+		LOGGER_MEMORY_BARRIER();
+		if( version == self->control_version ) {
+			return MUTEX_TURE;
+		}
+	}
+	return MUTEX_FALSE;
+}
+
 // ssize_t fsize(char const* filename){
 // 	struct stat st;
 // 	if(stat(filename, &st) == 0){
@@ -146,909 +266,3999 @@ unsigned int ocp_atoui( const char* str, size_t len, int base )
 /**
  * @memberof logger_t @private
  * @brief
- * 		Get the next file name.
+ * 		Get the next position.
  * @details
- * 		Given the current file name, <b>name</b>, compute the next name of
- * 		a file. <br>For example, the next name, with a max capacity of 40, of 039G2304
- * 		is 000G2305.
- * 		<br>With a max capacity of 120, the next name would of 103Y0032 would be
- * 		104Y0033.
- * @param current_name[in/out]
- * 		When this function is called, this is the current name of the file
- * 		pointed to by HEAD, when the function returns, this will now be the
- * 		name of the new file to be the new HEAD.
+ * 		Increment the sequence and temporal numbers of <b>position</b>, rolling them over if necessary.
+ * 		<br>For example, the next position, with a max capacity of 40, of 039G2304 is 000G2305.
+ * 		<br>With a max capacity of 120, the next position of 103Y0032 would be 104Y0033.
+ * 		<br>We can't use MOD for the sequence because logger_t::max_capacity can change dynamically. If it were
+ * 		to suddenly decrease and the sequence became greater than logger_t::max_capacity, the MOD would not
+ * 		return the desired value.
+ * @param position[in/out]
+ * 		When this function is called, this is the current position, when the function returns, this
+ * 		will be the next position.
  */
-static void logger_next_name( logger_t* self, char* name )
+static inline void logger_next_position( logger_t* self, logger_position_t* position )
 {
-
 	DEV_ASSERT(self);
-	DEV_ASSERT(name);
-
-	unsigned int next_seq = 0;
-	unsigned int next_tem = 0;
+	DEV_ASSERT(position);
 
-	/* Increment temporal and sequence number, then roll over if necessary.
-	 * We can't use MOD for next_seq because logger_t::max_capacity can change dynamically. If it were
-	 * to suddenly decrease and next_seq became greater than  logger_t::max_capacity, the MOD would not
-	 * return the desired value.
-	 */
-	next_seq = (logger_atoui(name + LOGGER_SEQUENCE_START, LOGGER_TOTAL_SEQUENCE_BYTES, LOGGER_SEQUENCE_BASE) + 1);
-	if( next_seq >= self->max_capacity ) {
-		next_seq = 0;
+	position->sequence = (position->sequence + 1 >= self->max_capacity) ? 0 : position->sequence + 1;
+	if( self->wide ) {
+		/* Rolls over at 2^32. */
+		++position->temporal;
+	} else {
+		position->temporal = (position->temporal + 1 >= LOGGER_MAX_TEMPORAL_POINTS) ? 0 : position->temporal + 1;
 	}
-	next_tem = (((name[4]-'0')*1000) + ((name[5]-'0')*100) + ((name[6]-'0')*10) + (name[7]-'0') + 1) % LOGGER_MAX_TEMPORAL_POINTS;
-
-	/* Convert numbers back to ascii and put in name string. */
-	logger_uitoa(next_seq, name + LOGGER_SEQUENCE_START, LOGGER_TOTAL_SEQUENCE_BYTES, LOGGER_SEQUENCE_BASE);
-//	name[2] = (char) ((next_seq % 20) + 'a') & 0xFF;
-//	next_seq = (next_seq - (next_seq % 20)) / 20; // basically a base ten logical shift right.
-//	name[1] = (char) ((next_seq % 20) + 'a') & 0xFF;
-//	next_seq = (next_seq - (next_seq % 10)) / 10; // basically a base ten logical shift right.
-//	name[0] = (char) ((next_seq % 20) + 'a') & 0xFF;
-
-	name[7] = (char) ((next_tem % 10) + '0') & 0xFF;
-	next_tem = (next_tem - (next_tem % 10)) / 10; // basically a base ten logical shift right.
-	name[6] = (char) ((next_tem % 10) + '0') & 0xFF;
-	next_tem = (next_tem - (next_tem % 10)) / 10; // basically a base ten logical shift right.
-	name[5] = (char) ((next_tem % 10) + '0') & 0xFF;
-	next_tem = (next_tem - (next_tem % 10)) / 10; // basically a base ten logical shift right.
-	name[4] = (char) ((next_tem % 10) + '0') & 0xFF;
-
-	//snprintf(name, LOGGER_TOTAL_SEQUENCE_BYTES, "%d", next_seq);
-	//snprintf(name+LOGGER_TEMPORAL_START, LOGGER_TOTAL_TEMPORAL_BYTES, "%d", next_tem);
 }
 
 /**
- * @memberof logger_t
- * @private
+ * @memberof logger_t @private
  * @brief
- * 		Creates a new control data file.
+ * 		Render the file name of the element at <b>position</b>.
  * @details
- * 		Creates a new control data file. All data is wiped from the existing file (if one
- * 		exists).
- * 		| HEAD (LOGGER_MAX_FILE_NAME_LENGTH+1 bytes) | TAIL (LOGGER_MAX_FILE_NAME_LENGTH+1 bytes) |
- * 		| HEAD sequence data (3 bytes) | HEAD temporal data (4 bytes) | popped temporal data (7 bytes) | reserved (2 bytes) |
+ * 		Table driven, no division loops: each hex digit of the sequence is one lookup and each pair
+ * 		of temporal digits is one lookup in logger_decimal_pairs.
+ * @param name[out]
+ * 		Must point to at least FILESYSTEM_MAX_NAME_LENGTH+1 bytes.
  */
-static logger_error_t logger_create_control_file( logger_t* self )
+static void logger_element_name( logger_t* self, logger_position_t const* position, char* name )
 {
 	DEV_ASSERT(self);
+	DEV_ASSERT(position);
+	DEV_ASSERT(name);
 
-	int32_t 	control_file_handle;
-	char 	control_string[LOGGER_CONTROL_DATA_LENGTH];
-	int32_t     bytes_write;
-
-	/* Write to a variable the initial set of control data. */
-	snprintf(control_string, LOGGER_CONTROL_DATA_LENGTH, "000%c0000.log%c000%c0000.log%c0000000000000000", self->element_file_name, '\0', self->element_file_name, '\0');
-	printf("%s",control_string);
+	uint32_t	sequence = position->sequence;
+	uint32_t	temporal = position->temporal;
+	char const*	pair;
+	int			i;
 
-	/* Open control file. */
-	control_file_handle = red_open(self->control_file_name, RED_O_WRONLY);
-	if( RED_FILE_ERR == control_file_handle) {
-		/* File system failure. */
-		//exit(red_errno);
-		return LOGGER_NVMEM_ERR;
+	if( self->wide ) {
+		/* Five bits per character, most significant first. */
+		for( i = LOGGER_WIDE_TEMPORAL_BYTES - 1; i >= 0; --i ) {
+			name[i] = logger_base32_digits[temporal & 0x1F];
+			temporal >>= 5;
+		}
+		name[LOGGER_WIDE_TEMPORAL_BYTES] = self->element_file_name;
+		memcpy(name + 8, LOGGER_WIDE_ELEMENT_EXTENSION, sizeof(LOGGER_WIDE_ELEMENT_EXTENSION));
+		return;
 	}
 
-	/* Write control data into control file. */
-	bytes_write = red_write(control_file_handle, control_string, LOGGER_CONTROL_DATA_LENGTH);
-	red_close(control_file_handle);
-	if( bytes_write == RED_FILE_ERR ) {
-		/* File system failure. */
-		return LOGGER_NVMEM_ERR;
-	} else if( bytes_write != LOGGER_CONTROL_DATA_LENGTH ) {
-		/* Out of memory :( */
-		printf("Create control file failed, read_bytes: %d\n", bytes_write);
-		return LOGGER_NVMEM_FULL;
-	}
-	return LOGGER_OK;
+	name[0] = logger_hex_digits[(sequence >> 8) & 0xF];
+	name[1] = logger_hex_digits[(sequence >> 4) & 0xF];
+	name[2] = logger_hex_digits[sequence & 0xF];
+	name[3] = self->element_file_name;
+	pair = logger_decimal_pairs + 2*(temporal / 100);
+	name[4] = pair[0];
+	name[5] = pair[1];
+	pair = logger_decimal_pairs + 2*(temporal % 100);
+	name[6] = pair[0];
+	name[7] = pair[1];
+	memcpy(name + 8, LOGGER_ELEMENT_EXTENSION, sizeof(LOGGER_ELEMENT_EXTENSION));
 }
 
 /**
- * @memberof logger_t
- * @private
+ * @memberof logger_t @private
  * @brief
- * 		Cache control.
+ * 		Parse the position out of an element file name.
  * @details
- * 		Caches control data from the control data file. If no control data file exists, it creates one.
+ * 		Only used when recovering the control data from flash.
  */
-static logger_error_t logger_cache_control_data( logger_t* self )
+static void logger_parse_name( char const* name, logger_position_t* position )
 {
-	DEV_ASSERT(self);
+	DEV_ASSERT(name);
+	DEV_ASSERT(position);
 
-	int32_t		control_file_handle;
-	int32_t	bytes_read;
-	logger_error_t lerr;
+	position->sequence = logger_atoui(name + LOGGER_SEQUENCE_START, LOGGER_TOTAL_SEQUENCE_BYTES, LOGGER_SEQUENCE_BASE);
+	position->temporal = logger_atoui(name + LOGGER_TEMPORAL_START, LOGGER_TOTAL_TEMPORAL_BYTES, 10) % LOGGER_MAX_TEMPORAL_POINTS;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Parse the temporal number out of a wide element file name.
+ * @returns
+ * 		false if <b>name</b> isn't a wide element name of this logger.
+ */
+static bool_t logger_parse_wide_name( logger_t* self, char const* name, uint32_t* temporal )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(name);
+	DEV_ASSERT(temporal);
 
+	uint32_t	value = 0;
+	char		c;
+	int			i;
 
-	control_file_handle = red_open(self->control_file_name, RED_O_RDONLY);
-	if( RED_FILE_ERR == control_file_handle ) {
-		/* Need to create the control file, it doesn't exist. */
-		lerr = logger_create_control_file(self);
-		if( lerr == LOGGER_OK ) {
-			control_file_handle = red_open(self->control_file_name, RED_O_RDONLY);
-			/* Make sure control file created successfully. */
-			if ( RED_FILE_ERR == control_file_handle) {
-				/* Error, return. */
-				return LOGGER_NVMEM_ERR;
-			}
-		}else {
-			return lerr;
-		}
+	if( name[LOGGER_WIDE_TEMPORAL_BYTES] != self->element_file_name ||
+		strcmp(name + 8, LOGGER_WIDE_ELEMENT_EXTENSION) != 0 ) {
+		return MUTEX_FALSE;
 	}
-	/* Cache HEAD. */
-	bytes_read = red_read(control_file_handle, self->head_file_name,  FILESYSTEM_MAX_NAME_LENGTH+1);
-	if(  RED_FILE_ERR == bytes_read ) {
-		/* Failed to read head into memory. */
-		red_close(control_file_handle);
-		return LOGGER_NVMEM_ERR;
-	} else if( bytes_read != (FILESYSTEM_MAX_NAME_LENGTH+1) ) {
-		/* File is too small, wipe it and create new one. */
-		return logger_create_control_file(self);
+	for( i = 0; i < LOGGER_WIDE_TEMPORAL_BYTES; ++i ) {
+		c = name[i];
+		if( c >= '0' && c <= '9' ) {
+			value = (value << 5) | (uint32_t) (c - '0');
+		} else if( c >= 'a' && c <= 'v' ) {
+			value = (value << 5) | (uint32_t) (c - 'a' + 10);
+		} else {
+			return MUTEX_FALSE;
+		}
 	}
-	self->head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+	*temporal = value;
+	return MUTEX_TURE;
+}
 
-	/* Cache TAIL. */
-	bytes_read = red_read(control_file_handle, self->tail_file_name,  FILESYSTEM_MAX_NAME_LENGTH+1);
-	red_close(control_file_handle);
-	if( RED_FILE_ERR == bytes_read ) {
-		/* Failed to read head into memory. */
-		return LOGGER_NVMEM_ERR;
-	} else if( bytes_read != (FILESYSTEM_MAX_NAME_LENGTH+1) ) {
-		/* File is too small, wipe it and create new one. */
-		return logger_create_control_file(self);
-	}
-	self->tail_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
-	return LOGGER_OK;
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Render the 7 digits of a popped temporal point.
+ * @param digits[out]
+ * 		Must point to at least LOGGER_TOTAL_POPPED_BYTES bytes. Not null terminated.
+ */
+static void logger_popped_digits( uint32_t point, char* digits )
+{
+	char const* pair;
+
+	point %= LOGGER_MAX_POPPED_POINTS;
+	digits[0] = logger_hex_digits[point / 1000000];
+	point %= 1000000;
+	pair = logger_decimal_pairs + 2*(point / 10000);
+	digits[1] = pair[0];
+	digits[2] = pair[1];
+	pair = logger_decimal_pairs + 2*((point / 100) % 100);
+	digits[3] = pair[0];
+	digits[4] = pair[1];
+	pair = logger_decimal_pairs + 2*(point % 100);
+	digits[5] = pair[0];
+	digits[6] = pair[1];
+}
+
+/* Two positions name the same element. */
+static inline bool_t logger_same_position( logger_position_t const* a, logger_position_t const* b )
+{
+	return (a->sequence == b->sequence) && (a->temporal == b->temporal);
 }
 
 /**
  * @memberof logger_t @private
  * @brief
- * 		Get the file name of the HEAD.
+ * 		Number of elements from <b>from</b> up to, but not including, <b>to</b>.
  * @details
- * 		Get the file name of the HEAD. This method just calls
- * 		logger_cache_control_data then returns logger_t::head_file_name.
+ * 		Only the sequence numbers are looked at.
  */
-static char* logger_get_head( logger_t* self, logger_error_t* err )
+static size_t logger_distance( logger_t* self, logger_position_t const* from, logger_position_t const* to )
 {
 	DEV_ASSERT(self);
-	DEV_ASSERT(err);
+	DEV_ASSERT(from);
+	DEV_ASSERT(to);
 
-	*err = logger_cache_control_data(self);
-	return self->head_file_name;
+	if( to->sequence >= from->sequence ) {
+		return to->sequence - from->sequence;
+	}
+	return (self->max_capacity - from->sequence) + to->sequence;
 }
 
 /**
  * @memberof logger_t @private
  * @brief
- * 		Set the file name of the HEAD.
- * @details
- * 		Set the file name of the HEAD.
- * @param head [in]
- * 		Must point to a string of at least FILESYSTEM_MAX_NAME_LENGTH bytes.
+ * 		Move <b>position</b> forward by <b>count</b> elements.
  */
-static logger_error_t logger_set_head( logger_t* self, char const* head )
+static inline void logger_advance_position( logger_t* self, logger_position_t* position, uint32_t count )
 {
 	DEV_ASSERT(self);
-	DEV_ASSERT(head);
+	DEV_ASSERT(position);
 
-	int32_t		control_file_handle;
-	int32_t	bytes_written;
+	position->sequence = (uint32_t) ((position->sequence + count) % self->max_capacity);
+	position->temporal += count;
+	if( !self->wide ) {
+		position->temporal %= LOGGER_MAX_TEMPORAL_POINTS;
+	}
+}
 
-	control_file_handle = red_open(self->control_file_name, RED_O_WRONLY);
-	if( RED_FILE_ERR == control_file_handle) {
-		/* File system failure. */
-		return LOGGER_NVMEM_ERR;
+/* Occupancy bitmap, one bit per slot. */
+static inline void logger_mark_slot( logger_t* self, uint32_t sequence )
+{
+	self->occupancy[sequence >> 5] |= (uint32_t) 1 << (sequence & 31);
+}
+
+static inline void logger_clear_slot( logger_t* self, uint32_t sequence )
+{
+	self->occupancy[sequence >> 5] &= ~((uint32_t) 1 << (sequence & 31));
+	if( self->element_bytes != NULL ) {
+		self->element_bytes[sequence] = 0;
 	}
+}
 
-	bytes_written = red_write(control_file_handle, head, FILESYSTEM_MAX_NAME_LENGTH);
-	red_close(control_file_handle);
-	if(  RED_FILE_ERR == bytes_written ) {
-		return LOGGER_NVMEM_ERR;
+/* Byte accounting, only kept while a quota is set. See logger_set_quota( ). */
+static inline void logger_count_bytes( logger_t* self, uint64_t bytes )
+{
+	self->bytes_stored += bytes;
+	if( self->quota != NULL ) {
+		logger_quota_count(self->quota, (int64_t) bytes);
 	}
-	if( bytes_written < FILESYSTEM_MAX_NAME_LENGTH ) {
-		return LOGGER_NVMEM_FULL;
+}
+
+static inline void logger_forget_bytes( logger_t* self, uint64_t bytes )
+{
+	bytes = (bytes > self->bytes_stored) ? self->bytes_stored : bytes;
+	self->bytes_stored -= bytes;
+	if( self->quota != NULL ) {
+		logger_quota_count(self->quota, -(int64_t) bytes);
 	}
-	return LOGGER_OK;
+}
+
+/* Same, for bytes of the element in slot <b>sequence</b>. See logger_set_size_table( ). */
+static inline void logger_count_element( logger_t* self, uint32_t sequence, uint64_t bytes )
+{
+	if( self->element_bytes != NULL ) {
+		self->element_bytes[sequence] += (uint32_t) bytes;
+	}
+	logger_count_bytes(self, bytes);
+}
+
+static inline void logger_forget_element( logger_t* self, uint32_t sequence, uint64_t bytes )
+{
+	if( self->element_bytes != NULL ) {
+		self->element_bytes[sequence] -= (bytes < self->element_bytes[sequence]) ? (uint32_t) bytes : self->element_bytes[sequence];
+	}
+	logger_forget_bytes(self, bytes);
 }
 
 /**
  * @memberof logger_t @private
  * @brief
- * 		Get the file name of the TAIL.
- * @details
- * 		Get the file name of the TAIL. This method just calls
- * 		logger_cache_control_data then returns logger_t::tail_file_name.
+ * 		First live slot in [<b>first</b>, <b>last</b>], no wrap around.
+ * @returns
+ * 		The slot, or logger_t::max_capacity if none are live.
  */
-static char* logger_get_tail( logger_t* self, logger_error_t* err )
+static uint32_t logger_find_slot_linear( logger_t* self, uint32_t first, uint32_t last )
 {
-	DEV_ASSERT(self);
-	DEV_ASSERT(err);
+	uint32_t word_index = first >> 5;
+	uint32_t last_index = last >> 5;
+	uint32_t word;
 
-	*err = logger_cache_control_data(self);
-	return self->tail_file_name;
+	word = self->occupancy[word_index] & (~(uint32_t) 0 << (first & 31));
+	for( ;; ) {
+		if( word_index == last_index && (last & 31) != 31 ) {
+			word &= ((uint32_t) 1 << ((last & 31) + 1)) - 1;
+		}
+		if( word != 0 ) {
+			return (word_index << 5) + LOGGER_FIND_FIRST_SET(word);
+		}
+		if( word_index == last_index ) {
+			return (uint32_t) self->max_capacity;
+		}
+		word = self->occupancy[++word_index];
+	}
 }
 
 /**
  * @memberof logger_t @private
  * @brief
- * 		Set the file name of the TAIL.
- * @details
- * 		Set the file name of the TAIL.
+ * 		First live slot walking forward from <b>first</b> to <b>last</b>, wrapping around the ring.
+ * @returns
+ * 		The slot, or logger_t::max_capacity if none are live.
  */
-static logger_error_t logger_set_tail( logger_t* self, char const* tail )
+static uint32_t logger_find_slot( logger_t* self, uint32_t first, uint32_t last )
 {
 	DEV_ASSERT(self);
-	DEV_ASSERT(tail);
 
-	int32_t		control_file_handle;
-	int32_t	bytes_written, ferr;
+	uint32_t slot;
 
-	control_file_handle = red_open(self->control_file_name, RED_O_WRONLY);
-	if( RED_FILE_ERR == control_file_handle) {
-		/* File system failure. */
-		return LOGGER_NVMEM_ERR;
+	if( first <= last ) {
+		return logger_find_slot_linear(self, first, last);
 	}
-
-	ferr = red_lseek(control_file_handle, LOGGER_META_TAIL_START, RED_SEEK_SET);
-	if( RED_FILE_ERR == ferr ) {
-		red_close(control_file_handle);
-		return LOGGER_NVMEM_ERR;
+	slot = logger_find_slot_linear(self, first, (uint32_t) self->max_capacity - 1);
+	if( slot != self->max_capacity ) {
+		return slot;
 	}
+	return logger_find_slot_linear(self, 0, last);
+}
 
-	bytes_written = red_write(control_file_handle, tail, FILESYSTEM_MAX_NAME_LENGTH);
-	red_close(control_file_handle);
-	if( bytes_written == RED_FILE_ERR ) {
-		return LOGGER_NVMEM_ERR;
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Last live slot in [<b>last</b>, <b>first</b>] walking down from <b>first</b>, no wrap around.
+ * @returns
+ * 		The slot, or logger_t::max_capacity if none are live.
+ */
+static uint32_t logger_find_slot_linear_reverse( logger_t* self, uint32_t first, uint32_t last )
+{
+	uint32_t word_index = first >> 5;
+	uint32_t last_index = last >> 5;
+	uint32_t word;
+
+	word = self->occupancy[word_index];
+	if( (first & 31) != 31 ) {
+		word &= ((uint32_t) 1 << ((first & 31) + 1)) - 1;
 	}
-	if( bytes_written < FILESYSTEM_MAX_NAME_LENGTH ) {
-		return LOGGER_NVMEM_FULL;
+	for( ;; ) {
+		if( word_index == last_index ) {
+			word &= ~(uint32_t) 0 << (last & 31);
+		}
+		if( word != 0 ) {
+			return (word_index << 5) + LOGGER_FIND_LAST_SET(word);
+		}
+		if( word_index == last_index ) {
+			return (uint32_t) self->max_capacity;
+		}
+		word = self->occupancy[--word_index];
 	}
-	return LOGGER_OK;
 }
 
 /**
- * @memberof logger_t
- * @private
+ * @memberof logger_t @private
  * @brief
- * 		Rename a file to remove it from the ring buffer's tracking.
- * @details
- * 		Rename a file to remove it from the ring buffer's tracking.
- * 		This will give the file the naming convention:
- * 		<br><b>Xaaaaaaa.bin</b>
- * 		<br>As defined in by logger_t documentation.
+ * 		First live slot walking backward from <b>first</b> to <b>last</b>, wrapping around the ring.
+ * @returns
+ * 		The slot, or logger_t::max_capacity if none are live.
  */
-static logger_error_t logger_untrack_file( logger_t* self, char* file_name )
+static uint32_t logger_find_slot_reverse( logger_t* self, uint32_t first, uint32_t last )
 {
 	DEV_ASSERT(self);
-	DEV_ASSERT(file_name);
 
-	char 		new_name[FILESYSTEM_MAX_NAME_LENGTH+1];
-	int32_t		control_file_handle;	
-	int			temporal_point;
-	int32_t	bytes_read, ferr;
+	uint32_t slot;
 
-	/* Open control file. */
-	control_file_handle = red_open(self->control_file_name, RED_O_RDWR);
-	if( RED_FILE_ERR == control_file_handle) {
-		/* File system failure. */
-		return LOGGER_NVMEM_ERR;
-	}
-	/* Seek to temporal data. */
-	ferr = red_lseek(control_file_handle, LOGGER_META_TEM_START, RED_SEEK_SET);
-	if( RED_FILE_ERR == ferr ) {
-		red_close(control_file_handle);
-		return LOGGER_NVMEM_ERR;
+	if( first >= last ) {
+		return logger_find_slot_linear_reverse(self, first, last);
 	}
-	
-	/* Get temporal point. */
-	bytes_read = red_read(control_file_handle, new_name+1, LOGGER_META_TEM_LENGTH);
-	if( bytes_read == RED_FILE_ERR || bytes_read != LOGGER_META_TEM_LENGTH ) {
-		red_close(control_file_handle);
-		return LOGGER_NVMEM_ERR;
+	slot = logger_find_slot_linear_reverse(self, first, 0);
+	if( slot != self->max_capacity ) {
+		return slot;
 	}
+	return logger_find_slot_linear_reverse(self, (uint32_t) self->max_capacity - 1, last);
+}
 
-	/* Finish off the name. */
-	new_name[0] = self->element_file_name;
-	new_name[8] = '.';
-	new_name[9] = 'b';
-	new_name[10] = 'i';
-	new_name[11] = 'n';
-	new_name[12] = '\0';
-
-	/* Get next temporal point. */
-	temporal_point = (((new_name[0]-'0')*1000000) + ((new_name[1]-'0')*100000) + ((new_name[2]-'0')*10000) + ((new_name[3]-'0')*1000) + ((new_name[4]-'0')*100) + ((new_name[5]-'0')*10) + ((new_name[6]-'0')*1) + 1) % (10*10*10*10*10*10*10);
-
-	/* Write the new point back to string. */
-	new_name[7] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[6] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[5] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[4] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[3] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[2] = (char) ((temporal_point % 10) + '0') & 0xFF;
-	temporal_point = (temporal_point - (temporal_point% 10)) / 10; // basically a base ten logical shift right.
-	new_name[1] = (char) ((temporal_point % 10) + '0') & 0xFF;
-
-	/* Update new temporal point in file. */
-	/* Seek to temporal data. */
-	ferr = red_lseek(control_file_handle, LOGGER_META_TEM_START, RED_SEEK_SET);
-	if( RED_FILE_ERR == ferr ) {
-		red_close(control_file_handle);
-		return LOGGER_NVMEM_ERR;
-	}
-	
-	/* Set temporal point. */
-	bytes_read = red_write(control_file_handle, (new_name+1), LOGGER_META_TEM_LENGTH);
-	red_close(control_file_handle);
-	if( bytes_read == RED_FILE_ERR || bytes_read != LOGGER_META_TEM_LENGTH ) {
-		return LOGGER_NVMEM_ERR;
-	}
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Move <b>position</b> back by <b>count</b> elements.
+ */
+static inline void logger_retreat_position( logger_t* self, logger_position_t* position, uint32_t count )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(position);
 
-	/* Rename the file, first, check if a file with this name already exist. If it does, delete it. */
-	control_file_handle = red_open(new_name, RED_O_RDWR);
-	if( control_file_handle != RED_FILE_ERR ) {
-		red_close(control_file_handle);
-		ferr = red_rmdir(new_name);
-		if(RED_FILE_ERR == ferr){
-			return LOGGER_NVMEM_ERR;
-		}
-	}
-	ferr = red_rename(file_name, new_name);
-	if( RED_FILE_ERR == ferr ) {
-		return LOGGER_NVMEM_ERR;
+	position->sequence = (uint32_t) ((position->sequence + self->max_capacity - (count % self->max_capacity)) % self->max_capacity);
+	if( self->wide ) {
+		position->temporal -= count;
+	} else {
+		position->temporal = (position->temporal + LOGGER_MAX_TEMPORAL_POINTS - (count % LOGGER_MAX_TEMPORAL_POINTS)) % LOGGER_MAX_TEMPORAL_POINTS;
 	}
-
-	strncpy(file_name, new_name, FILESYSTEM_MAX_NAME_LENGTH);
-	file_name[FILESYSTEM_MAX_NAME_LENGTH] = "\0";
-	return LOGGER_OK;
 }
 
 /**
- * @memberof logger_t
- * @private
+ * @memberof logger_t @private
  * @brief
- * 		Update tail position.
+ * 		Check <b>position</b> names an element that is still in the ring buffer.
  * @details
- * 		Updates the position of the tail in the ring buffer. This is useful when asynchronous
- * 		file removals have rendered the tail position corrupt (ie, pointing to a non existant file).
- * @returns
- * 		Error code
+ * 		It must be between the TAIL and HEAD, its slot must be live and, since the slot may have
+ * 		been reused since, its temporal number must be the one the HEAD implies for that slot.
+ * 		Must hold the mutex with logger_t::occupancy built.
  */
-static logger_error_t logger_update_tail( logger_t* self )
+static bool_t logger_is_live( logger_t* self, logger_position_t const* position )
 {
 	DEV_ASSERT(self);
+	DEV_ASSERT(position);
 
-	int32_t 			fp;
-	char*			tail_file_name;
-	char*			head_file_name;
-	logger_error_t	lerr;
-	unsigned int	i;
-	//fs_error_t		ferr;
-	bool_t			do_update = false;
+	logger_position_t	expected = *position;
+	uint32_t			behind;
 
-	tail_file_name = logger_get_tail(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		return lerr;
+	if( !(self->occupancy[position->sequence >> 5] & ((uint32_t) 1 << (position->sequence & 31))) ) {
+		return MUTEX_FALSE;
 	}
-
-	head_file_name = logger_get_head(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		return lerr;
+	behind = (uint32_t) logger_distance(self, position, &self->head);
+	if( behind > logger_distance(self, &self->tail, &self->head) ) {
+		return MUTEX_FALSE;
 	}
+	logger_advance_position(self, &expected, behind);
+	return expected.temporal == self->head.temporal;
+}
 
-	/* From the current tail, there is a maximum of logger_t::max_capacity elements to search. */
-	for( i = 0; i < self->max_capacity; ++i ) {
-		/* Check if this tail file exists (ie, check if it has been asynchronously removed. */
-		fp = red_open(tail_file_name, RED_O_RDONLY);
-		if( RED_FILE_ERR == fp ) {
-			/* The file doesn't exist. See if this is also the HEAD file. */
-			/* If HEAD == TAIL and this file doesn't exist then the buffer has */
-			/* been asynchronously emptied (all files deleted). */
-			if( 0 == strncmp(tail_file_name, head_file_name, FILESYSTEM_MAX_NAME_LENGTH) ) {
-				return LOGGER_EMPTY;
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Set the cached HEAD and TAIL, and render their names.
+ */
+static void logger_cache_positions( logger_t* self, logger_position_t const* head, logger_position_t const* tail )
+{
+	DEV_ASSERT(self);
+
+	logger_write_begin(self);
+	if( head != NULL ) {
+		self->head = *head;
+		logger_element_name(self, head, self->head_file_name);
+	}
+	if( tail != NULL ) {
+		if( logger_same_position(&self->retired, &self->tail) ) {
+			/* Nothing waiting to be swept, keep it that way. */
+			self->retired = *tail;
+		}
+		self->tail = *tail;
+		logger_element_name(self, tail, self->tail_file_name);
+	}
+	logger_write_end(self);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Put control data read from flash into the in RAM cache.
+ */
+static void logger_load_control_data( logger_t* self, logger_position_t* head, logger_position_t* tail, uint32_t popped_point, uint32_t generation )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+	DEV_ASSERT(tail);
+
+	if( head->sequence >= self->max_capacity ) {
+		head->sequence = 0;
+	}
+	if( tail->sequence >= self->max_capacity ) {
+		tail->sequence = 0;
+	}
+	if( !self->wide ) {
+		head->temporal %= LOGGER_MAX_TEMPORAL_POINTS;
+		tail->temporal %= LOGGER_MAX_TEMPORAL_POINTS;
+	}
+	self->popped_point = popped_point % LOGGER_MAX_POPPED_POINTS;
+	self->control_generation = generation;
+	logger_cache_positions(self, head, tail);
+	/* Files waiting to be swept are found again by the occupancy scan. */
+	self->retired = *tail;
+	self->occupancy_valid = MUTEX_FALSE;
+	self->control_data_cached = MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Parse a control file in the old text format.
+ * @details
+ * 		| HEAD (FILESYSTEM_MAX_NAME_LENGTH+1 bytes) | TAIL (FILESYSTEM_MAX_NAME_LENGTH+1 bytes) |
+ * 		| unused (7 bytes) | popped temporal data (7 bytes) | reserved (2 bytes) |
+ * 		<br>This is the only place names are parsed.
+ * @returns
+ * 		false if <b>control_string</b> isn't in this format.
+ */
+static bool_t logger_load_legacy_control_data( logger_t* self, char const* control_string )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(control_string);
+
+	logger_position_t head, tail;
+
+	if( self->wide ||
+		control_string[LOGGER_META_HEAD_START+3] != self->element_file_name ||
+		control_string[LOGGER_META_TAIL_START+3] != self->element_file_name ||
+		memcmp(control_string + LOGGER_META_HEAD_START + 8, LOGGER_ELEMENT_EXTENSION, 4) != 0 ||
+		memcmp(control_string + LOGGER_META_TAIL_START + 8, LOGGER_ELEMENT_EXTENSION, 4) != 0 ) {
+		return MUTEX_FALSE;
+	}
+
+	logger_parse_name(control_string + LOGGER_META_HEAD_START, &head);
+	logger_parse_name(control_string + LOGGER_META_TAIL_START, &tail);
+	logger_load_control_data(self, &head, &tail,
+							 logger_atoui(control_string + LOGGER_META_TEM_START, LOGGER_META_TEM_LENGTH, 10),
+							 0);
+	return MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Build one control record.
+ * @details
+ * 		| magic | generation | HEAD sequence | HEAD temporal | TAIL sequence | TAIL temporal |
+ * 		| popped temporal point | CRC-32 of the preceding 28 bytes |
+ * 		<br>All fields are 32 bit little endian.
+ */
+static void logger_encode_control( uint8_t* record, uint32_t generation, logger_position_t const* head, logger_position_t const* tail, uint32_t popped_point )
+{
+	logger_put_u32(record + 0, LOGGER_CONTROL_MAGIC);
+	logger_put_u32(record + 4, generation);
+	logger_put_u32(record + 8, head->sequence);
+	logger_put_u32(record + 12, head->temporal);
+	logger_put_u32(record + 16, tail->sequence);
+	logger_put_u32(record + 20, tail->temporal);
+	logger_put_u32(record + 24, popped_point);
+	logger_put_u32(record + 28, logger_crc32(LOGGER_CRC32_INIT, record, LOGGER_CONTROL_RECORD_LENGTH - 4));
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Check a control record read from flash.
+ * @returns
+ * 		true if the magic and CRC match. <b>generation</b> is only written in that case.
+ */
+static bool_t logger_check_control( uint8_t const* record, uint32_t* generation )
+{
+	if( logger_get_u32(record) != LOGGER_CONTROL_MAGIC ) {
+		return MUTEX_FALSE;
+	}
+	if( logger_get_u32(record + 28) != logger_crc32(LOGGER_CRC32_INIT, record, LOGGER_CONTROL_RECORD_LENGTH - 4) ) {
+		return MUTEX_FALSE;
+	}
+	*generation = logger_get_u32(record + 4);
+	return MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_t
+ * @private
+ * @brief
+ * 		Creates a new control data file.
+ * @details
+ * 		Creates a new control data file. All data is wiped from the existing file (if one
+ * 		exists). The file holds LOGGER_CONTROL_SLOTS records, see logger_encode_control( ).
+ * 		The initial record goes in the slot for generation 1, the other slot is zeroed.
+ */
+static logger_error_t logger_create_control_file( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	int32_t 			control_file_handle;
+	uint8_t 			control_data[LOGGER_CONTROL_FILE_LENGTH];
+	int32_t     		bytes_write;
+	logger_position_t	origin = { 0, 0 };
+
+	/* Write to a variable the initial set of control data. */
+	memset(control_data, 0, sizeof(control_data));
+	logger_encode_control(control_data + LOGGER_CONTROL_RECORD_LENGTH, 1, &origin, &origin, 0);
+
+	/* Open control file. */
+	control_file_handle = red_open(self->control_file_name, RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC);
+	if( RED_FILE_ERR == control_file_handle) {
+		/* File system failure. */
+		//exit(red_errno);
+		return LOGGER_NVMEM_ERR;
+	}
+
+	/* Write control data into control file. */
+	bytes_write = red_write(control_file_handle, control_data, LOGGER_CONTROL_FILE_LENGTH);
+	red_close(control_file_handle);
+	if( bytes_write == RED_FILE_ERR ) {
+		/* File system failure. */
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_ERR;
+	} else if( bytes_write != LOGGER_CONTROL_FILE_LENGTH ) {
+		/* Out of memory :( */
+		printf("Create control file failed, read_bytes: %d\n", bytes_write);
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_FULL;
+	}
+
+	/* The control file now matches the initial control data, so cache it. A journal, time index */
+	/* or checksums left over from before describe a ring that no longer exists. */
+	logger_load_control_data(self, &origin, &origin, 0, 1);
+	red_unlink(self->journal_file_name);
+	red_unlink(self->index_file_name);
+	red_unlink(self->checksum_file_name);
+	self->journal_records = 0;
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Write new control data to the control file.
+ * @details
+ * 		The record for the next generation is written over the older of the two slots with a
+ * 		single write, the newest record is never touched. If the write tears, the other slot
+ * 		still holds the previous state. The cache is only updated once the write succeeds.
+ */
+static logger_error_t logger_write_record( logger_t* self, logger_position_t const* head, logger_position_t const* tail, uint32_t popped_point )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+	DEV_ASSERT(tail);
+
+	int32_t		control_file_handle;
+	int32_t		bytes_written, ferr;
+	uint8_t		record[LOGGER_CONTROL_RECORD_LENGTH];
+	uint32_t	generation = self->control_generation + 1;
+
+	popped_point %= LOGGER_MAX_POPPED_POINTS;
+	logger_encode_control(record, generation, head, tail, popped_point);
+
+	control_file_handle = red_open(self->control_file_name, RED_O_WRONLY);
+	if( RED_FILE_ERR == control_file_handle) {
+		/* File system failure. */
+		return LOGGER_NVMEM_ERR;
+	}
+
+	ferr = red_lseek(control_file_handle, (generation % LOGGER_CONTROL_SLOTS) * LOGGER_CONTROL_RECORD_LENGTH, RED_SEEK_SET);
+	if( RED_FILE_ERR == ferr ) {
+		red_close(control_file_handle);
+		return LOGGER_NVMEM_ERR;
+	}
+
+	bytes_written = red_write(control_file_handle, record, LOGGER_CONTROL_RECORD_LENGTH);
+	red_close(control_file_handle);
+	if( bytes_written == RED_FILE_ERR ) {
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_ERR;
+	}
+	if( bytes_written < LOGGER_CONTROL_RECORD_LENGTH ) {
+		/* Partial write, the slot is torn. Re-read on next use to pick up the good one. */
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_FULL;
+	}
+
+	self->control_generation = generation;
+	self->popped_point = popped_point;
+	logger_cache_positions(self, head, tail);
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Checkpoint control data.
+ * @details
+ * 		Writes a control record, then empties the journal. If power is lost in
+ * 		between, replaying the journal over the new record changes nothing, journal records
+ * 		hold absolute values.
+ */
+static logger_error_t logger_checkpoint( logger_t* self, logger_position_t const* head, logger_position_t const* tail, uint32_t popped_point )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t	lerr;
+	int32_t			journal_handle;
+
+	lerr = logger_write_record(self, head, tail, popped_point);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	journal_handle = red_open(self->journal_file_name, RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC);
+	if( RED_FILE_ERR == journal_handle ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	red_close(journal_handle);
+	self->journal_records = 0;
+	return LOGGER_OK;
+}
+
+/* | op (1 byte) | sequence (3 bytes) | temporal or popped point (4 bytes) | CRC-32 of the preceding 8 bytes | */
+static void logger_encode_journal( uint8_t* record, uint8_t op, uint32_t sequence, uint32_t value )
+{
+	record[0] = op;
+	record[1] = (uint8_t) sequence;
+	record[2] = (uint8_t) (sequence >> 8);
+	record[3] = (uint8_t) (sequence >> 16);
+	logger_put_u32(record + 4, value);
+	logger_put_u32(record + 8, logger_crc32(LOGGER_CRC32_INIT, record, LOGGER_JOURNAL_RECORD_LENGTH - 4));
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Write new control data to the journal.
+ * @details
+ * 		Only what changed is appended, with one write. Once logger_t::journal_interval records
+ * 		have been appended the state is checkpointed. The cache is only updated once the write
+ * 		succeeds.
+ */
+static logger_error_t logger_write_journal( logger_t* self, logger_position_t const* head, logger_position_t const* tail, uint32_t popped_point )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+	DEV_ASSERT(tail);
+
+	uint8_t		records[3*LOGGER_JOURNAL_RECORD_LENGTH];
+	uint32_t	length = 0;
+	int32_t		journal_handle;
+	int32_t		bytes_written;
+
+	popped_point %= LOGGER_MAX_POPPED_POINTS;
+	if( !logger_same_position(head, &self->head) ) {
+		logger_encode_journal(records + length, LOGGER_JOURNAL_HEAD, head->sequence, head->temporal);
+		length += LOGGER_JOURNAL_RECORD_LENGTH;
+	}
+	if( !logger_same_position(tail, &self->tail) ) {
+		logger_encode_journal(records + length, LOGGER_JOURNAL_TAIL, tail->sequence, tail->temporal);
+		length += LOGGER_JOURNAL_RECORD_LENGTH;
+	}
+	if( popped_point != self->popped_point ) {
+		logger_encode_journal(records + length, LOGGER_JOURNAL_POPPED, 0, popped_point);
+		length += LOGGER_JOURNAL_RECORD_LENGTH;
+	}
+	if( length == 0 ) {
+		return LOGGER_OK;
+	}
+
+	journal_handle = red_open(self->journal_file_name, RED_O_WRONLY | RED_O_CREAT | RED_O_APPEND);
+	if( RED_FILE_ERR == journal_handle ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	bytes_written = red_write(journal_handle, records, length);
+	red_close(journal_handle);
+	if( bytes_written == RED_FILE_ERR ) {
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_ERR;
+	}
+	if( bytes_written < (int32_t) length ) {
+		/* Torn record at the end of the journal. Replay stops there and checkpoints. */
+		self->control_data_cached = MUTEX_FALSE;
+		return LOGGER_NVMEM_FULL;
+	}
+
+	self->popped_point = popped_point;
+	logger_cache_positions(self, head, tail);
+	self->journal_records += length / LOGGER_JOURNAL_RECORD_LENGTH;
+	if( self->journal_records >= self->journal_interval ) {
+		return logger_checkpoint(self, &self->head, &self->tail, self->popped_point);
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Write new control data.
+ * @details
+ * 		To the journal if it's enabled, otherwise straight to the control file. While the journal
+ * 		is disabled it is kept empty.
+ */
+static inline logger_error_t logger_write_control( logger_t* self, logger_position_t const* head, logger_position_t const* tail, uint32_t popped_point )
+{
+	if( self->journal_interval != 0 ) {
+		return logger_write_journal(self, head, tail, popped_point);
+	}
+	if( self->journal_records != 0 ) {
+		/* Left over from before the journal was disabled. It must not be replayed over this record. */
+		return logger_checkpoint(self, head, tail, popped_point);
+	}
+	return logger_write_record(self, head, tail, popped_point);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Apply the journal to the control data just loaded.
+ * @details
+ * 		Stops at the first record that is short or fails its CRC. Anything after that point could
+ * 		never be reached by a later replay, so in that case the state is checkpointed right away.
+ * 		The journal never holds more than a checkpoint interval's worth of records, so this is bounded.
+ */
+static logger_error_t logger_replay_journal( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	uint8_t				records[LOGGER_JOURNAL_READ_RECORDS*LOGGER_JOURNAL_RECORD_LENGTH];
+	uint8_t const*		record;
+	int32_t				journal_handle;
+	int32_t				bytes_read;
+	int32_t				offset;
+	logger_position_t	head = self->head;
+	logger_position_t	tail = self->tail;
+	uint32_t			popped_point = self->popped_point;
+	uint32_t			replayed = 0;
+	bool_t				torn = MUTEX_FALSE;
+
+	journal_handle = red_open(self->journal_file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == journal_handle ) {
+		/* No journal. */
+		self->journal_records = 0;
+		return LOGGER_OK;
+	}
+
+	do {
+		bytes_read = red_read(journal_handle, records, sizeof(records));
+		if( RED_FILE_ERR == bytes_read ) {
+			red_close(journal_handle);
+			return LOGGER_NVMEM_ERR;
+		}
+		for( offset = 0; offset < bytes_read; offset += LOGGER_JOURNAL_RECORD_LENGTH ) {
+			record = records + offset;
+			if( bytes_read - offset < LOGGER_JOURNAL_RECORD_LENGTH ||
+				logger_get_u32(record + 8) != logger_crc32(LOGGER_CRC32_INIT, record, LOGGER_JOURNAL_RECORD_LENGTH - 4) ) {
+				torn = MUTEX_TURE;
+				break;
+			}
+			switch( record[0] ) {
+				case LOGGER_JOURNAL_HEAD:
+					head.sequence = (uint32_t) record[1] | ((uint32_t) record[2] << 8) | ((uint32_t) record[3] << 16);
+					head.temporal = logger_get_u32(record + 4);
+					break;
+				case LOGGER_JOURNAL_TAIL:
+					tail.sequence = (uint32_t) record[1] | ((uint32_t) record[2] << 8) | ((uint32_t) record[3] << 16);
+					tail.temporal = logger_get_u32(record + 4);
+					break;
+				case LOGGER_JOURNAL_POPPED:
+					popped_point = logger_get_u32(record + 4);
+					break;
+				default:
+					torn = MUTEX_TURE;
+					break;
 			}
+			if( torn ) {
+				break;
+			}
+			++replayed;
+		}
+	} while( !torn && bytes_read == (int32_t) sizeof(records) );
+	red_close(journal_handle);
+
+	if( replayed > 0 ) {
+		logger_load_control_data(self, &head, &tail, popped_point, self->control_generation);
+	}
+	self->journal_records = replayed;
+	if( torn ) {
+		return logger_checkpoint(self, &self->head, &self->tail, self->popped_point);
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t
+ * @private
+ * @brief
+ * 		Cache control.
+ * @details
+ * 		Caches control data from the control data file. If no control data file exists, it creates one.
+ * 		Both records are fetched with a single read and the newest one with a good CRC wins, so a
+ * 		torn write only loses the update being made. A control file in the old text format is
+ * 		migrated. The ring is only reset if nothing usable is found.
+ * 		<br>Once cached, logger_t owns the HEAD, TAIL and popped temporal data; they are only read
+ * 		back from flash again by logger_revalidate( ).
+ */
+static logger_error_t logger_cache_control_data( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	int32_t				control_file_handle;
+	int32_t				bytes_read;
+	uint8_t				control_data[LOGGER_CONTROL_FILE_LENGTH];
+	uint8_t const*		record;
+	uint8_t const*		newest = NULL;
+	uint32_t			generation, newest_generation = 0;
+	logger_position_t	head, tail;
+	unsigned int		slot;
+
+	control_file_handle = red_open(self->control_file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == control_file_handle ) {
+		/* Need to create the control file, it doesn't exist. */
+		return logger_create_control_file(self);
+	}
+
+	bytes_read = red_read(control_file_handle, control_data, LOGGER_CONTROL_FILE_LENGTH);
+	red_close(control_file_handle);
+	if( RED_FILE_ERR == bytes_read ) {
+		/* Failed to read control data into memory. */
+		return LOGGER_NVMEM_ERR;
+	}
+
+	/* Newest valid record. Generations wrap, so compare by difference. */
+	for( slot = 0; slot < LOGGER_CONTROL_SLOTS; ++slot ) {
+		if( bytes_read < (int32_t) ((slot + 1) * LOGGER_CONTROL_RECORD_LENGTH) ) {
+			break;
+		}
+		record = control_data + slot * LOGGER_CONTROL_RECORD_LENGTH;
+		if( !logger_check_control(record, &generation) ) {
+			continue;
+		}
+		if( newest == NULL || (int32_t) (generation - newest_generation) > 0 ) {
+			newest = record;
+			newest_generation = generation;
+		}
+	}
+
+	if( newest != NULL ) {
+		head.sequence = logger_get_u32(newest + 8);
+		head.temporal = logger_get_u32(newest + 12);
+		tail.sequence = logger_get_u32(newest + 16);
+		tail.temporal = logger_get_u32(newest + 20);
+		logger_load_control_data(self, &head, &tail, logger_get_u32(newest + 24), newest_generation);
+		return logger_replay_journal(self);
+	}
+
+	/* Old text format, rewrite it as a record. */
+	if( bytes_read >= LOGGER_META_TEM_START + LOGGER_META_TEM_LENGTH &&
+		logger_load_legacy_control_data(self, (char const*) control_data) ) {
+		return logger_write_record(self, &self->head, &self->tail, self->popped_point);
+	}
+
+	/* Nothing usable, wipe it and create new one. */
+	return logger_create_control_file(self);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Make sure control data is cached.
+ * @details
+ * 		Only touches the control file if the cache has been invalidated.
+ */
+static inline logger_error_t logger_require_control_data( logger_t* self )
+{
+	if( self->control_data_cached ) {
+		return LOGGER_OK;
+	}
+	return logger_cache_control_data(self);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Get the position of the HEAD.
+ * @details
+ * 		Returns the cached logger_t::head, the control file is only read if the cache is not valid.
+ */
+static logger_position_t const* logger_get_head( logger_t* self, logger_error_t* err )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(err);
+
+	*err = logger_require_control_data(self);
+	return &self->head;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Set the position of the HEAD.
+ * @details
+ * 		Set the position of the HEAD. See logger_write_control( ).
+ */
+static inline logger_error_t logger_set_head( logger_t* self, logger_position_t const* head )
+{
+	return logger_write_control(self, head, &self->tail, self->popped_point);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Get the position of the TAIL.
+ * @details
+ * 		Returns the cached logger_t::tail, the control file is only read if the cache is not valid.
+ */
+static logger_position_t const* logger_get_tail( logger_t* self, logger_error_t* err )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(err);
+
+	*err = logger_require_control_data(self);
+	return &self->tail;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Set the position of the TAIL.
+ * @details
+ * 		Set the position of the TAIL. See logger_write_control( ).
+ */
+static inline logger_error_t logger_set_tail( logger_t* self, logger_position_t const* tail )
+{
+	return logger_write_control(self, &self->head, tail, self->popped_point);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Write the popped temporal point to the control file.
+ * @details
+ * 		See logger_write_control( ).
+ */
+static inline logger_error_t logger_set_popped_point( logger_t* self, uint32_t point )
+{
+	return logger_write_control(self, &self->head, &self->tail, point);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Get the name of a popped file.
+ * @details
+ * 		<br><b>Xaaaaaaa.bin</b>
+ * 		<br>Where <b>aaaaaaa</b> is <b>point</b>.
+ * @param name[out]
+ * 		Must point to at least FILESYSTEM_MAX_NAME_LENGTH+1 bytes.
+ */
+static void logger_popped_name( logger_t* self, uint32_t point, char* name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(name);
+
+	name[0] = self->element_file_name;
+	logger_popped_digits(point, name + 1);
+	memcpy(name + 8, LOGGER_POPPED_EXTENSION, sizeof(LOGGER_POPPED_EXTENSION));
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Rename a file, replacing any file that already has the new name.
+ * @details
+ * 		The rename is tried first, the existing file is only removed if the rename reports
+ * 		the new name is taken. In the common case this costs a single file system operation.
+ * @returns
+ * 		0 on success, RED_FILE_ERR otherwise with red_errno set by the failing call.
+ */
+static int32_t logger_rename_over( char const* old_name, char const* new_name )
+{
+	if( red_rename(old_name, new_name) == 0 ) {
+		return 0;
+	}
+	if( red_errno != RED_EEXIST ) {
+		return RED_FILE_ERR;
+	}
+	if( red_unlink(new_name) != 0 ) {
+		return RED_FILE_ERR;
+	}
+	return red_rename(old_name, new_name);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Name of the pool file at <b>index</b>.
+ */
+static void logger_pool_name( logger_t* self, uint32_t index, char* name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(name);
+
+	name[0] = self->element_file_name;
+	memcpy(name + 1, "pool0", 5);
+	/* index is below LOGGER_POOL_MAX. */
+	name[6] = logger_decimal_pairs[index * 2];
+	name[7] = logger_decimal_pairs[index * 2 + 1];
+	memcpy(name + 8, LOGGER_POOL_EXTENSION, sizeof(LOGGER_POOL_EXTENSION));
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Build logger_t::occupancy.
+ * @details
+ * 		One pass over LOGGER_ELEMENT_DIRECTORY. A slot is live if a file exists with the exact name
+ * 		the element in that slot would have, counting back from the HEAD. Leftovers from an earlier
+ * 		lap of the ring (same slot, older temporal number) don't count, and files with the right name
+ * 		behind the TAIL are popped files waiting for logger_sweep( ), they set logger_t::retired. For wide loggers the slot
+ * 		comes from how far the file's temporal number is behind the HEAD's. The sizes of the live
+ * 		files give logger_t::bytes_stored. Pool files not in logger_t::pool_ready are deleted.
+ * 		<br>The caller must hold the mutex and the control data must be cached.
+ */
+static logger_error_t logger_scan_occupancy( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	REDDIR*				directory;
+	REDDIRENT*			entry;
+	logger_position_t	position;
+	uint32_t			behind, live, oldest;
+	uint32_t			pool_found = 0, index;
+	char				pool_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+
+	memset(self->occupancy, 0, self->occupancy_words * sizeof(uint32_t));
+	if( self->element_bytes != NULL ) {
+		memset(self->element_bytes, 0, self->max_capacity * sizeof(uint32_t));
+	}
+	logger_forget_bytes(self, self->bytes_stored);
+	live = (uint32_t) logger_distance(self, &self->tail, &self->head);
+	oldest = live;
+
+	directory = red_opendir(LOGGER_ELEMENT_DIRECTORY);
+	if( directory == NULL ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	while( (entry = red_readdir(directory)) != NULL ) {
+		if( strlen(entry->d_name) != FILESYSTEM_MAX_NAME_LENGTH ) {
+			continue;
+		}
+		if( entry->d_name[0] == self->element_file_name && memcmp(entry->d_name + 1, "pool0", 5) == 0 &&
+			strcmp(entry->d_name + 8, LOGGER_POOL_EXTENSION) == 0 ) {
+			/* Pool file, stale unless it is one logger_set_pool( ) has made since. */
+			index = (uint32_t) (entry->d_name[6] - '0') * 10 + (uint32_t) (entry->d_name[7] - '0');
+			if( index < LOGGER_POOL_MAX ) {
+				pool_found |= (uint32_t) 1 << index;
+			}
+			continue;
+		}
+		if( self->wide ) {
+			/* Only the temporal number is in the name, how far it is behind the HEAD gives the slot. */
+			if( !logger_parse_wide_name(self, entry->d_name, &position.temporal) ) {
+				continue;
+			}
+			behind = self->head.temporal - position.temporal;
+			if( behind <= live ) {
+				position.sequence = (uint32_t) ((self->head.sequence + self->max_capacity - behind) % self->max_capacity);
+				logger_mark_slot(self, position.sequence);
+				logger_count_element(self, position.sequence, entry->d_stat.st_size);
+			} else if( behind < self->max_capacity && behind > oldest ) {
+				/* Popped, not swept yet. */
+				oldest = behind;
+			}
+			continue;
+		}
+		if( entry->d_name[LOGGER_SEQUENCE_START + LOGGER_TOTAL_SEQUENCE_BYTES] != self->element_file_name ||
+			strcmp(entry->d_name + 8, LOGGER_ELEMENT_EXTENSION) != 0 ) {
+			continue;
+		}
+		logger_parse_name(entry->d_name, &position);
+		if( position.sequence >= self->max_capacity ) {
+			continue;
+		}
+		behind = (uint32_t) logger_distance(self, &position, &self->head) % LOGGER_MAX_TEMPORAL_POINTS;
+		if( (position.temporal + behind) % LOGGER_MAX_TEMPORAL_POINTS != self->head.temporal ) {
+			continue;
+		}
+		if( behind <= live ) {
+			logger_mark_slot(self, position.sequence);
+			logger_count_element(self, position.sequence, entry->d_stat.st_size);
+		} else if( behind > oldest ) {
+			/* Popped, not swept yet. */
+			oldest = behind;
+		}
+	}
+	red_closedir(directory);
+
+	/* Left behind by a reset, or a pool that has since shrunk. */
+	pool_found &= ~self->pool_ready;
+	while( pool_found != 0 ) {
+		index = LOGGER_FIND_FIRST_SET(pool_found);
+		pool_found &= ~((uint32_t) 1 << index);
+		logger_pool_name(self, index, pool_file_name);
+		red_unlink(pool_file_name);
+	}
+
+	self->retired = self->head;
+	logger_retreat_position(self, &self->retired, oldest);
+
+	self->occupancy_valid = MUTEX_TURE;
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Make sure the control data is cached and logger_t::occupancy is built.
+ */
+static logger_error_t logger_require_occupancy( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t lerr;
+
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	if( !self->occupancy_valid ) {
+		return logger_scan_occupancy(self);
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t
+ * @private
+ * @brief
+ * 		Rename a file to remove it from the ring buffer's tracking.
+ * @details
+ * 		Rename a file to remove it from the ring buffer's tracking.
+ * 		This will give the file the naming convention:
+ * 		<br><b>Xaaaaaaa.bin</b>
+ * 		<br>As defined in by logger_t documentation. The popped temporal point comes from
+ * 		the cache, only the incremented value is written back to the control file.
+ * @param file_name[in/out]
+ * 		The name of the file, replaced by its new name.
+ */
+static logger_error_t logger_untrack_file( logger_t* self, char* file_name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(file_name);
+
+	char 		new_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t	temporal_point;
+	logger_error_t lerr;
+
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	/* Get next temporal point. */
+	temporal_point = (self->popped_point + 1) % LOGGER_MAX_POPPED_POINTS;
+	logger_popped_name(self, temporal_point, new_name);
+
+	/* Update new temporal point in file before using it, so a name is never handed out twice. */
+	lerr = logger_set_popped_point(self, temporal_point);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	/* Rename the file. If a file with this name already exist it is replaced. */
+	if( RED_FILE_ERR == logger_rename_over(file_name, new_name) ) {
+		return LOGGER_NVMEM_ERR;
+	}
+
+	memcpy(file_name, new_name, FILESYSTEM_MAX_NAME_LENGTH+1);
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t
+ * @private
+ * @brief
+ * 		Update tail position.
+ * @details
+ * 		Updates the position of the tail in the ring buffer. This is useful when asynchronous
+ * 		file removals have rendered the tail position corrupt (ie, pointing to a non existant file).
+ * 		Candidates come from logger_t::occupancy, so only slots believed live are opened; a
+ * 		candidate whose file has gone is cleared from the bitmap and the search carries on.
+ * 		The control file is only written if the TAIL actually moved.
+ * @returns
+ * 		Error code
+ */
+static logger_error_t logger_update_tail( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	int32_t 			fp;
+	logger_position_t	tail;
+	char				tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	logger_error_t		lerr;
+	uint32_t			slot;
+	unsigned int		i;
+
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	tail = self->tail;
+
+	/* From the current tail, there is a maximum of logger_t::max_capacity elements to search. */
+	for( i = 0; i < self->max_capacity; ++i ) {
+		/* Next slot, up to and including the HEAD, that should still have a file. */
+		slot = logger_find_slot(self, tail.sequence, self->head.sequence);
+		if( slot == self->max_capacity ) {
+			/* Nothing left up to the HEAD, the buffer has been asynchronously emptied */
+			/* (all files deleted). */
+			return LOGGER_EMPTY;
+		}
+		logger_advance_position(self, &tail, (uint32_t) (slot >= tail.sequence ?
+												slot - tail.sequence :
+												self->max_capacity - tail.sequence + slot));
+
+		/* Check the file really exists (ie, check if it has been asynchronously removed). */
+		logger_element_name(self, &tail, tail_file_name);
+		fp = red_open(tail_file_name, RED_O_RDONLY);
+		if( RED_FILE_ERR != fp ) {
+			red_close(fp);
+			break;
+		}
+
+		/* Removed behind our back. Its size is unknown now, so the byte count has to be rebuilt. */
+		logger_clear_slot(self, slot);
+		if( self->byte_quota != 0 ) {
+			self->occupancy_valid = MUTEX_FALSE;
+		}
+		if( logger_same_position(&tail, &self->head) ) {
+			return LOGGER_EMPTY;
+		}
+		logger_next_position(self, &tail);
+	}
+
+	if( !logger_same_position(&tail, &self->tail) ) {
+		/* Update the tail meta data. */
+		return logger_set_tail(self, &tail);
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Set the positions of the HEAD and TAIL.
+ * @details
+ * 		Both land in the same record, so this costs the same as moving either one.
+ */
+static inline logger_error_t logger_set_head_and_tail( logger_t* self, logger_position_t const* head, logger_position_t const* tail )
+{
+	return logger_write_control(self, head, tail, self->popped_point);
+}
+
+/* Size of an open file, 0 if it can't be read. */
+static uint64_t logger_handle_bytes( int32_t handle )
+{
+	REDSTAT stat;
+
+	if( red_fstat(handle, &stat) != 0 ) {
+		return 0;
+	}
+	return stat.st_size;
+}
+
+/* Size of a file by name, 0 if it doesn't exist. */
+static uint64_t logger_file_bytes( char const* name )
+{
+	int32_t		handle;
+	uint64_t	bytes;
+
+	handle = red_open(name, RED_O_RDONLY);
+	if( RED_FILE_ERR == handle ) {
+		return 0;
+	}
+	bytes = logger_handle_bytes(handle);
+	red_close(handle);
+	return bytes;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Bytes counted for the element in slot <b>sequence</b>, named <b>name</b>.
+ * @details
+ * 		Taken from logger_t::element_bytes when it is kept, otherwise the file is opened.
+ */
+static uint64_t logger_element_bytes( logger_t* self, uint32_t sequence, char const* name )
+{
+	DEV_ASSERT(self);
+
+	if( self->element_bytes != NULL ) {
+		return self->element_bytes[sequence];
+	}
+	return logger_file_bytes(name);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Delete the TAIL element and move <b>tail</b> forward.
+ * @details
+ * 		A missing file is a hole left by an asynchronous removal, it is skipped over. Nothing is
+ * 		written to the control file, the caller persists the final TAIL.
+ * @param tail[in/out]
+ * 		Working copy of the TAIL position.
+ */
+static logger_error_t logger_remove_tail( logger_t* self, logger_position_t* tail )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(tail);
+
+	char		tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint64_t	bytes = 0;
+
+	logger_element_name(self, tail, tail_file_name);
+	if( self->byte_quota != 0 ) {
+		bytes = logger_element_bytes(self, tail->sequence, tail_file_name);
+	}
+	if( red_unlink(tail_file_name) != 0 && red_errno != RED_ENOENT ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	logger_forget_element(self, tail->sequence, bytes);
+	logger_clear_slot(self, tail->sequence);
+	logger_next_position(self, tail);
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Delete TAIL elements until the logger is within its byte quota.
+ * @details
+ * 		Never deletes <b>head</b>, so a single element larger than the quota is kept.
+ * @param head[in]
+ * 		The HEAD the caller is about to persist.
+ * @param tail[in/out]
+ * 		Working copy of the TAIL position.
+ */
+static logger_error_t logger_evict_for_quota( logger_t* self, logger_position_t const* head, logger_position_t* tail )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+	DEV_ASSERT(tail);
+
+	logger_error_t lerr;
+
+	while( self->byte_quota != 0 && self->bytes_stored > self->byte_quota && !logger_same_position(tail, head) ) {
+		lerr = logger_remove_tail(self, tail);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Make room in the ring buffer for a new HEAD.
+ * @details
+ * 		If <b>head</b> overlaps <b>tail</b> the TAIL element is deleted and <b>tail</b> is
+ * 		incremented. Before the first eviction the TAIL is corrected for asynchronous file removals
+ * 		with logger_update_tail( ), since that may already have made room. Nothing is written
+ * 		to the control file for the eviction itself, the caller persists the final TAIL.
+ * @param head[in]
+ * 		The position the next HEAD will take.
+ * @param tail[in/out]
+ * 		Working copy of the TAIL position, advanced past any evicted element.
+ * @param tail_checked[in/out]
+ * 		Must be false the first time this is called with a working copy of the cached TAIL. Set
+ * 		once logger_update_tail( ) has been run.
+ */
+static logger_error_t logger_evict_for_head( logger_t* self, logger_position_t const* head, logger_position_t* tail, bool_t* tail_checked )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+	DEV_ASSERT(tail);
+	DEV_ASSERT(tail_checked);
+
+	logger_error_t	lerr;
+
+	/* Check if HEAD == TAIL. To do this, we only need to look at the sequence numbers. */
+	if( tail->sequence != head->sequence ) {
+		return LOGGER_OK;
+	}
+
+	/* HEAD and TAIL are overlapping. */
+	/* Since asynchronous file removals can happen, lets first update position of the TAIL and then see if */
+	/* the HEAD and TAIL still overlap. */
+	if( !*tail_checked ) {
+		lerr = logger_update_tail(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+		*tail = self->tail;
+		*tail_checked = MUTEX_TURE;
+		if( tail->sequence != head->sequence ) {
+			return LOGGER_OK;
+		}
+	}
+
+	/* HEAD and TAIL still overlap. Remove the TAIL so it can be replaced. */
+	return logger_remove_tail(self, tail);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Rename or delete up to <b>max</b> popped files, oldest first.
+ * @details
+ * 		Must hold the mutex. Renames reserve their popped temporal points with one control data
+ * 		update. Files already gone are stepped over without taking a point, the points they had
+ * 		reserved are handed back with a second update.
+ */
+static logger_error_t logger_sweep_locked( logger_t* self, size_t max, size_t* swept )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t	lerr = LOGGER_OK, commit_err;
+	char			file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	char			new_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t		point = 0;
+	size_t			count, i, renamed = 0;
+	int32_t			result;
+
+	count = logger_distance(self, &self->retired, &self->tail);
+	if( count > max ) {
+		count = max;
+	}
+	if( swept != NULL ) {
+		*swept = 0;
+	}
+	if( count == 0 ) {
+		return LOGGER_OK;
+	}
+
+	if( self->retire_mode != LOGGER_RETIRE_DELETE ) {
+		point = (self->popped_point + 1) % LOGGER_MAX_POPPED_POINTS;
+		lerr = logger_set_popped_point(self, (uint32_t) ((point + count - 1) % LOGGER_MAX_POPPED_POINTS));
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+
+	for( i = 0; i < count; ++i ) {
+		logger_element_name(self, &self->retired, file_name);
+		if( self->retire_mode == LOGGER_RETIRE_DELETE ) {
+			result = red_unlink(file_name);
+		} else {
+			logger_popped_name(self, point, new_name);
+			result = logger_rename_over(file_name, new_name);
+			if( RED_FILE_ERR != result ) {
+				/* Gaps don't take a point. */
+				point = (point + 1) % LOGGER_MAX_POPPED_POINTS;
+				++renamed;
+			}
+		}
+		if( RED_FILE_ERR == result && red_errno != RED_ENOENT ) {
+			lerr = LOGGER_NVMEM_ERR;
+			break;
+		}
+		logger_next_position(self, &self->retired);
+	}
+	if( swept != NULL ) {
+		*swept = i;
+	}
+
+	/* Hand back the points reserved for gaps, the next sweep carries on from the last one used. */
+	if( self->retire_mode != LOGGER_RETIRE_DELETE && renamed < count ) {
+		commit_err = logger_set_popped_point(self, (point + LOGGER_MAX_POPPED_POINTS - 1) % LOGGER_MAX_POPPED_POINTS);
+		if( lerr == LOGGER_OK ) {
+			lerr = commit_err;
+		}
+	}
+	return lerr;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Make sure <b>head</b> doesn't land on a popped file still waiting to be swept.
+ */
+static inline logger_error_t logger_sweep_for_head( logger_t* self, logger_position_t const* head )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(head);
+
+	if( logger_same_position(&self->retired, &self->tail) || head->sequence != self->retired.sequence ) {
+		return LOGGER_OK;
+	}
+	return logger_sweep_locked(self, 1, NULL);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Create the missing pool files.
+ * @details
+ * 		Must hold the mutex.
+ */
+static logger_error_t logger_fill_pool_locked( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	char		pool_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	int32_t		pool_handle;
+	uint32_t	index;
+
+	for( index = 0; index < self->pool_size; ++index ) {
+		if( self->pool_ready & ((uint32_t) 1 << index) ) {
+			continue;
+		}
+		logger_pool_name(self, index, pool_file_name);
+		pool_handle = red_open(pool_file_name, RED_O_RDWR | RED_O_CREAT | RED_O_TRUNC);
+		if( RED_FILE_ERR == pool_handle ) {
+			return (red_errno == RED_ENOSPC) ? LOGGER_NVMEM_FULL : LOGGER_NVMEM_ERR;
+		}
+		red_close(pool_handle);
+		self->pool_ready |= (uint32_t) 1 << index;
+	}
+	return LOGGER_OK;
+}
+
+static void logger_submit_upkeep( logger_t* self, uint8_t op, bool_t* queued );
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Move a file into the ring buffer at the given HEAD name.
+ * @details
+ * 		Due to corruption, a file by the HEAD name may exist already, it is replaced.
+ * 		Pass <b>file_name</b> as NULL to insert an empty file instead, claimed from the
+ * 		pool if there is one ready.
+ * @returns
+ * 		An opened handle for the file, or RED_FILE_ERR.
+ */
+static int32_t logger_place_file( logger_t* self, char const* head, char const* file_name )
+{
+	DEV_ASSERT(self);
+
+	char		new_head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t	index;
+
+	/* First check if we are inserting an empty file. */
+	if( file_name == NULL ) {
+		if( self->pool_ready != 0 ) {
+			/* Claim a pre-created file and have the writer task replace it. */
+			index = LOGGER_FIND_FIRST_SET(self->pool_ready);
+			self->pool_ready &= ~((uint32_t) 1 << index);
+			logger_pool_name(self, index, new_head_file_name);
+			logger_submit_upkeep(self, LOGGER_REQUEST_REFILL, &self->pool_queued);
+			if( logger_rename_over(new_head_file_name, head) == 0 ) {
+				return red_open(head, RED_O_RDWR);
+			}
+		}
+		/* Inserting an empty file, lets create it. */
+		return red_open(head, RED_O_RDWR | RED_O_CREAT);
+	}
+
+	/* Inserting the file given as a function argument. Lets process that string to avoid some errors. */
+	strncpy(new_head_file_name, file_name, FILESYSTEM_MAX_NAME_LENGTH);
+	new_head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+	/* Now rename it so that the ring buffer can track it. */
+	if( logger_rename_over(new_head_file_name, head) != 0 ) {
+		/* Failed to rename it, all we can do is abort. */
+		return RED_FILE_ERR;
+	}
+	/* Finally, lets open it. */
+	return red_open(head, RED_O_RDWR);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Stamp the element at <b>position</b> with <b>timestamp</b> in the time index.
+ * @details
+ * 		Must hold the mutex. The index only speeds up logger_find_range( ), so a failed write is
+ * 		not an error, the record just won't match the element.
+ */
+static void logger_index_element( logger_t* self, logger_position_t const* position, uint32_t timestamp )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(position);
+
+	uint8_t		record[LOGGER_INDEX_RECORD_LENGTH];
+	int32_t		index_handle;
+
+	logger_put_u32(record, timestamp);
+	logger_put_u32(record + 4, position->temporal ^ LOGGER_INDEX_KEY);
+
+	index_handle = red_open(self->index_file_name, RED_O_WRONLY | RED_O_CREAT);
+	if( RED_FILE_ERR == index_handle ) {
+		return;
+	}
+	/* Seeking past the end of a new index leaves a gap of zeros, which never matches. */
+	if( red_lseek(index_handle, (int64_t) position->sequence * LOGGER_INDEX_RECORD_LENGTH, RED_SEEK_SET) != RED_FILE_ERR ) {
+		red_write(index_handle, record, LOGGER_INDEX_RECORD_LENGTH);
+	}
+	red_close(index_handle);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Read the time stamp of the element <b>index</b> slots from the TAIL.
+ * @details
+ * 		Must hold the mutex.
+ * @returns
+ * 		MUTEX_FALSE if the element isn't in the index.
+ */
+static bool_t logger_index_lookup( logger_t* self, int32_t index_handle, uint32_t index, uint32_t* timestamp )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(timestamp);
+
+	uint8_t				record[LOGGER_INDEX_RECORD_LENGTH];
+	logger_position_t	position = self->tail;
+
+	logger_advance_position(self, &position, index);
+	if( red_lseek(index_handle, (int64_t) position.sequence * LOGGER_INDEX_RECORD_LENGTH, RED_SEEK_SET) == RED_FILE_ERR ||
+		red_read(index_handle, record, LOGGER_INDEX_RECORD_LENGTH) != LOGGER_INDEX_RECORD_LENGTH ) {
+		return MUTEX_FALSE;
+	}
+	/* A stale record belongs to an element that used to be in this slot. */
+	if( (logger_get_u32(record + 4) ^ LOGGER_INDEX_KEY) != position.temporal ) {
+		return MUTEX_FALSE;
+	}
+	*timestamp = logger_get_u32(record);
+	return MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Binary search the time index for the first element in [<b>low</b>, <b>high</b>) stamped
+ * 		at or after <b>timestamp</b>.
+ * @details
+ * 		Must hold the mutex. Elements missing from the index are stepped over, which
+ * 		degrades to a linear scan if most of the index is missing.
+ * @returns
+ * 		Index from the TAIL, <b>high</b> if there is no such element.
+ */
+static uint32_t logger_index_search( logger_t* self, int32_t index_handle, uint32_t low, uint32_t high, uint32_t timestamp )
+{
+	DEV_ASSERT(self);
+
+	uint32_t	found = high;
+	uint32_t	middle, probe, stamp;
+
+	while( low < high ) {
+		middle = low + (high - low) / 2;
+		for( probe = middle; probe < high; ++probe ) {
+			if( logger_index_lookup(self, index_handle, probe, &stamp) ) {
+				break;
+			}
+		}
+		if( probe == high ) {
+			/* Nothing indexed in the upper half. */
+			high = middle;
+		} else if( stamp < timestamp ) {
+			low = probe + 1;
+		} else {
+			found = probe;
+			high = middle;
+		}
+	}
+	return found;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Record the CRC and length of the element at <b>position</b>.
+ * @details
+ * 		Must hold the mutex. Checksums only save reading the element again, so a failed write is
+ * 		not an error.
+ */
+static void logger_record_checksum( logger_t* self, logger_position_t const* position, uint32_t crc, uint32_t length )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(position);
+
+	uint8_t		record[LOGGER_CHECKSUM_RECORD_LENGTH];
+	int32_t		checksum_handle;
+
+	logger_put_u32(record, crc);
+	logger_put_u32(record + 4, length);
+	logger_put_u32(record + 8, position->temporal ^ LOGGER_CHECKSUM_KEY);
+
+	checksum_handle = red_open(self->checksum_file_name, RED_O_WRONLY | RED_O_CREAT);
+	if( RED_FILE_ERR == checksum_handle ) {
+		return;
+	}
+	if( red_lseek(checksum_handle, (int64_t) position->sequence * LOGGER_CHECKSUM_RECORD_LENGTH, RED_SEEK_SET) != RED_FILE_ERR ) {
+		red_write(checksum_handle, record, LOGGER_CHECKSUM_RECORD_LENGTH);
+	}
+	red_close(checksum_handle);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Read the recorded CRC and length of the element at <b>position</b>.
+ * @details
+ * 		Must hold the mutex.
+ * @returns
+ * 		MUTEX_FALSE if there is no record for the element.
+ */
+static bool_t logger_checksum_lookup( logger_t* self, logger_position_t const* position, uint32_t* crc, uint32_t* length )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(position);
+	DEV_ASSERT(crc);
+	DEV_ASSERT(length);
+
+	uint8_t		record[LOGGER_CHECKSUM_RECORD_LENGTH];
+	int32_t		checksum_handle;
+	int32_t		bytes_read = RED_FILE_ERR;
+
+	checksum_handle = red_open(self->checksum_file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == checksum_handle ) {
+		return MUTEX_FALSE;
+	}
+	if( red_lseek(checksum_handle, (int64_t) position->sequence * LOGGER_CHECKSUM_RECORD_LENGTH, RED_SEEK_SET) != RED_FILE_ERR ) {
+		bytes_read = red_read(checksum_handle, record, LOGGER_CHECKSUM_RECORD_LENGTH);
+	}
+	red_close(checksum_handle);
+
+	/* A stale record belongs to an element that used to be in this slot. */
+	if( bytes_read != LOGGER_CHECKSUM_RECORD_LENGTH || (logger_get_u32(record + 8) ^ LOGGER_CHECKSUM_KEY) != position->temporal ) {
+		return MUTEX_FALSE;
+	}
+	*crc = logger_get_u32(record);
+	*length = logger_get_u32(record + 4);
+	return MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Compute the CRC and length of a file by reading it.
+ */
+static logger_error_t logger_checksum_file( char const* file_name, uint32_t* crc, uint32_t* length )
+{
+	DEV_ASSERT(file_name);
+	DEV_ASSERT(crc);
+	DEV_ASSERT(length);
+
+	uint8_t		buffer[LOGGER_CHECKSUM_READ_LENGTH];
+	int32_t		file_handle;
+	int32_t		bytes_read;
+
+	file_handle = red_open(file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == file_handle ) {
+		return LOGGER_EMPTY;
+	}
+	*crc = LOGGER_CRC32_INIT;
+	*length = 0;
+	while( (bytes_read = red_read(file_handle, buffer, sizeof(buffer))) > 0 ) {
+		*crc = logger_crc32(*crc, buffer, (size_t) bytes_read);
+		*length += (uint32_t) bytes_read;
+	}
+	red_close(file_handle);
+	return (RED_FILE_ERR == bytes_read) ? LOGGER_NVMEM_ERR : LOGGER_OK;
+}
+
+/* Add appended data to the CRC of the HEAD. */
+static inline void logger_checksum_head( logger_t* self, void const* data, size_t length )
+{
+	if( self->checksums && self->head_crc_valid ) {
+		self->head_crc = logger_crc32(self->head_crc, data, length);
+	}
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Make sure the HEAD file exists.
+ * @details
+ * 		If the HEAD file doesn't exist the logger was emptied via asynchronous file removal
+ * 		and the control data is reset.
+ */
+static logger_error_t logger_check_head( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t	lerr;
+	int32_t			head_file_handle;
+
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	if( (head_file_handle = red_open(self->head_file_name, RED_O_RDONLY)) == RED_FILE_ERR ) {
+		return logger_create_control_file(self); /* FIXME: only reset head/tail pointers - not temporal data too */
+	}
+	red_close(head_file_handle);
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Write the staged append data to the HEAD.
+ * @details
+ * 		Must hold the mutex.
+ */
+static logger_error_t logger_flush_locked( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	int32_t bytes_written;
+	size_t	length = self->append_length;
+
+	if( length == 0 ) {
+		return LOGGER_OK;
+	}
+	DEV_ASSERT(self->head_handle != RED_FILE_ERR);
+
+	self->append_length = 0;
+	bytes_written = red_write(self->head_handle, self->append_buffer, (uint32_t) length);
+	if( RED_FILE_ERR == bytes_written ) {
+		self->head_size -= length;
+		self->head_crc_valid = MUTEX_FALSE;
+		return LOGGER_NVMEM_ERR;
+	}
+	logger_count_element(self, self->head.sequence, (uint64_t) bytes_written);
+	if( (size_t) bytes_written < length ) {
+		/* Out of memory, the rest is lost. */
+		self->head_size -= length - (size_t) bytes_written;
+		self->head_crc_valid = MUTEX_FALSE;
+		return LOGGER_NVMEM_FULL;
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Flush and close the handle logger_append( ) keeps on the HEAD.
+ * @details
+ * 		Must hold the mutex. Must be called before the HEAD moves.
+ */
+static logger_error_t logger_seal_head( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t lerr;
+
+	if( self->head_handle == RED_FILE_ERR ) {
+		return LOGGER_OK;
+	}
+	lerr = logger_flush_locked(self);
+	if( self->checksums && self->head_crc_valid ) {
+		logger_record_checksum(self, &self->head, self->head_crc, (uint32_t) self->head_size);
+	}
+	red_close(self->head_handle);
+	self->head_handle = RED_FILE_ERR;
+	self->head_size = 0;
+	return lerr;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Insert a file into the ring buffer.
+ * @details
+ * 		Same as logger_insert( ) but the caller must hold the mutex, and the handle
+ * 		is left open.
+ * @returns
+ * 		An opened handle for the file inserted, or RED_FILE_ERR.
+ */
+static int32_t logger_insert_locked( logger_t* self, logger_error_t* err, char const* file_to_insert_name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(err);
+
+	logger_error_t 		lerr;
+	logger_position_t	head, tail;
+	char				head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	int32_t				head_file_handle;
+	bool_t				tail_checked = MUTEX_FALSE;
+	uint64_t			bytes;
+
+	/* The HEAD is about to move, finish off any appending to it. */
+	logger_seal_head(self);
+	self->head_rotate = MUTEX_FALSE;
+
+	/* Get the position of the HEAD and TAIL. */
+	lerr = logger_check_head(self);
+	if( lerr != LOGGER_OK ) {
+		*err = lerr;
+		return RED_FILE_ERR;
+	}
+
+	if( self->byte_quota != 0 || self->retire_mode != LOGGER_RETIRE_NOW ) {
+		lerr = logger_require_occupancy(self);
+		if( lerr != LOGGER_OK ) {
+			*err = lerr;
+			return RED_FILE_ERR;
+		}
+	}
+
+	/* Increment HEAD to next element. Work on copies so the cache only changes once the */
+	/* control file has been written. */
+	head = self->head;
+	tail = self->tail;
+	logger_next_position(self, &head);
+
+	lerr = logger_sweep_for_head(self, &head);
+	if( lerr != LOGGER_OK ) {
+		*err = lerr;
+		return RED_FILE_ERR;
+	}
+	lerr = logger_evict_for_head(self, &head, &tail, &tail_checked);
+	if( lerr != LOGGER_OK ) {
+		*err = lerr;
+		return RED_FILE_ERR;
+	}
+	
+	/* Insert at HEAD. */
+	logger_element_name(self, &head, head_file_name);
+	head_file_handle = logger_place_file(self, head_file_name, file_to_insert_name);
+
+	/* Check we opened the file without errors. */
+	if( RED_FILE_ERR == head_file_handle ) {
+		/* Failed to open the file, all we can do is abort. */
+		if( !logger_same_position(&tail, &self->tail) ) {
+			/* Still record the eviction. */
+			logger_set_tail(self, &tail);
+		}
+		*err = LOGGER_NVMEM_ERR;
+		return RED_FILE_ERR;
+	}
+	/* Make room for it under the byte quota. */
+	if( self->byte_quota != 0 ) {
+		bytes = logger_handle_bytes(head_file_handle);
+		logger_count_element(self, head.sequence, bytes);
+		lerr = logger_evict_for_quota(self, &head, &tail);
+		if( lerr != LOGGER_OK ) {
+			logger_forget_element(self, head.sequence, bytes);
+			red_close(head_file_handle);
+			if( !logger_same_position(&tail, &self->tail) ) {
+				logger_set_tail(self, &tail);
+			}
+			*err = lerr;
+			return RED_FILE_ERR;
+		}
+	}
+
+	/* The file is open and named such that it can be the HEAD, so, lets make it so. */
+	if( !logger_same_position(&tail, &self->tail) ) {
+		lerr = logger_set_head_and_tail(self, &head, &tail);
+	} else {
+		lerr = logger_set_head(self, &head);
+	}
+	if( lerr != LOGGER_OK ) {
+		/* Failed to set HEAD. */
+		red_close(head_file_handle);
+		*err = lerr;
+		return RED_FILE_ERR;
+	}
+	/* Insert successful.. */
+	logger_mark_slot(self, head.sequence);
+	if( self->time_source != NULL ) {
+		logger_index_element(self, &head, self->time_source());
+	}
+	*err = LOGGER_OK;
+	return head_file_handle;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Insert several files into the ring buffer.
+ * @details
+ * 		Same as logger_insert_batch( ) but the caller must hold the mutex.
+ */
+static logger_error_t logger_insert_batch_locked( logger_t* self, char const* const file_names[], size_t count, size_t* inserted )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(file_names);
+
+	logger_error_t 		lerr, commit_err;
+	logger_position_t	head, next_head, tail;
+	char				head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	int32_t				head_file_handle;
+	bool_t				tail_checked = MUTEX_FALSE;
+	size_t				i;
+	uint32_t			timestamp = 0;
+
+	if( inserted != NULL ) {
+		*inserted = 0;
+	}
+	if( self->time_source != NULL ) {
+		timestamp = self->time_source();
+	}
+
+	logger_seal_head(self);
+	self->head_rotate = MUTEX_FALSE;
+	lerr = logger_check_head(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	if( self->byte_quota != 0 || self->retire_mode != LOGGER_RETIRE_NOW ) {
+		lerr = logger_require_occupancy(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+
+	head = self->head;
+	tail = self->tail;
+
+	/* Rename every file into place, evicting from the TAIL as we go. Only the working copies */
+	/* of HEAD and TAIL move, the control file is written once at the end. */
+	for( i = 0; i < count; ++i ) {
+		next_head = head;
+		logger_next_position(self, &next_head);
+
+		lerr = logger_sweep_for_head(self, &next_head);
+		if( lerr != LOGGER_OK ) {
+			break;
+		}
+		lerr = logger_evict_for_head(self, &next_head, &tail, &tail_checked);
+		if( lerr != LOGGER_OK ) {
+			break;
+		}
+
+		logger_element_name(self, &next_head, head_file_name);
+		head_file_handle = logger_place_file(self, head_file_name, file_names[i]);
+		if( RED_FILE_ERR == head_file_handle ) {
+			lerr = LOGGER_NVMEM_ERR;
+			break;
+		}
+		if( self->byte_quota != 0 ) {
+			logger_count_element(self, next_head.sequence, logger_handle_bytes(head_file_handle));
+		}
+		red_close(head_file_handle);
+		logger_mark_slot(self, next_head.sequence);
+		if( self->time_source != NULL ) {
+			logger_index_element(self, &next_head, timestamp);
+		}
+		head = next_head;
+
+		lerr = logger_evict_for_quota(self, &head, &tail);
+		if( lerr != LOGGER_OK ) {
+			++i;
+			break;
+		}
+	}
+
+	/* Persist whatever made it into the ring buffer, even if we stopped early. */
+	commit_err = LOGGER_OK;
+	if( !logger_same_position(&tail, &self->tail) ) {
+		commit_err = logger_set_head_and_tail(self, &head, &tail);
+	} else if( i > 0 ) {
+		commit_err = logger_set_head(self, &head);
+	}
+
+	if( inserted != NULL && commit_err == LOGGER_OK ) {
+		*inserted = i;
+	}
+	return (lerr != LOGGER_OK) ? lerr : commit_err;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Open the HEAD for logger_append( ).
+ * @details
+ * 		Must hold the mutex. Appending continues in the current HEAD file if it exists and
+ * 		is under the rotation size, otherwise a new empty element is inserted.
+ * @param rotate
+ * 		Always insert a new element, the current HEAD has been sealed for rotation.
+ */
+static logger_error_t logger_open_head( logger_t* self, bool_t rotate )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t	lerr;
+	REDSTAT			stat;
+	int64_t			offset;
+	uint32_t		length;
+
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	self->head_handle = (rotate || self->head_rotate) ? RED_FILE_ERR : red_open(self->head_file_name, RED_O_RDWR);
+	self->head_rotate = MUTEX_FALSE;
+	if( self->head_handle != RED_FILE_ERR ) {
+		if( red_fstat(self->head_handle, &stat) != 0 ||
+			(self->rotate_size != 0 && stat.st_size >= self->rotate_size) ) {
+			red_close(self->head_handle);
+			self->head_handle = RED_FILE_ERR;
+		} else {
+			offset = red_lseek(self->head_handle, 0, RED_SEEK_END);
+			if( RED_FILE_ERR == offset ) {
+				red_close(self->head_handle);
+				self->head_handle = RED_FILE_ERR;
+				return LOGGER_NVMEM_ERR;
+			}
+			self->head_size = (size_t) offset;
+
+			/* Carry on from the CRC recorded when it was closed, if it covers the whole file. */
+			self->head_crc_valid = MUTEX_FALSE;
+			if( self->checksums && logger_checksum_lookup(self, &self->head, &self->head_crc, &length) ) {
+				self->head_crc_valid = (length == (uint32_t) offset) ? MUTEX_TURE : MUTEX_FALSE;
+			}
+		}
+	}
+
+	if( self->head_handle == RED_FILE_ERR ) {
+		/* Start a new element. */
+		self->head_handle = logger_insert_locked(self, &lerr, NULL);
+		if( self->head_handle == RED_FILE_ERR ) {
+			return lerr;
+		}
+		self->head_size = 0;
+		self->head_crc = LOGGER_CRC32_INIT;
+		self->head_crc_valid = MUTEX_TURE;
+	}
+	self->head_opened = xTaskGetTickCount();
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Check if the HEAD must be rotated before <b>length</b> more bytes go into it.
+ */
+static bool_t logger_needs_rotation( logger_t* self, size_t length )
+{
+	DEV_ASSERT(self);
+
+	if( self->head_handle == RED_FILE_ERR || self->head_size == 0 ) {
+		return MUTEX_FALSE;
+	}
+	if( self->rotate_size != 0 && self->head_size + length > self->rotate_size ) {
+		return MUTEX_TURE;
+	}
+	if( self->rotate_age != 0 && (xTaskGetTickCount() - self->head_opened) >= self->rotate_age ) {
+		return MUTEX_TURE;
+	}
+	return MUTEX_FALSE;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Evict from the TAIL until the logger is within its byte quota, and persist the TAIL.
+ * @details
+ * 		Must hold the mutex.
+ */
+static logger_error_t logger_enforce_quota( logger_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t		lerr, commit_err;
+	logger_position_t	tail;
+
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	tail = self->tail;
+	lerr = logger_evict_for_quota(self, &self->head, &tail);
+	commit_err = LOGGER_OK;
+	if( !logger_same_position(&tail, &self->tail) ) {
+		commit_err = logger_set_tail(self, &tail);
+	}
+	return (lerr != LOGGER_OK) ? lerr : commit_err;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Append a record to the HEAD.
+ * @details
+ * 		Same as logger_append( ) but the caller must hold the mutex.
+ */
+static logger_error_t logger_append_locked( logger_t* self, void const* buffer, size_t length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( buffer || length == 0 );
+
+	logger_error_t	lerr;
+	uint8_t const*	data = (uint8_t const*) buffer;
+	size_t			room, start, on_file;
+	int32_t			bytes_written;
+	uint32_t		crc;
+	bool_t			crc_valid;
+
+	/* A record never spans two elements. */
+	if( logger_needs_rotation(self, length) ) {
+		lerr = logger_seal_head(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+		lerr = logger_open_head(self, MUTEX_TURE);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+	if( self->head_handle == RED_FILE_ERR ) {
+		lerr = logger_open_head(self, MUTEX_FALSE);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+
+	/* Where the record starts, to take it back out if a write fails part way. */
+	start = self->head_size;
+	crc = self->head_crc;
+	crc_valid = self->head_crc_valid;
+
+	/* Stage in RAM. A flush only happens once the staged data reaches the next multiple of */
+	/* LOGGER_APPEND_BUFFER_SIZE in the file, so writes to flash are large and aligned. */
+	lerr = LOGGER_OK;
+	while( length > 0 ) {
+		room = LOGGER_APPEND_BUFFER_SIZE - (self->head_size % LOGGER_APPEND_BUFFER_SIZE);
+		if( self->append_length == 0 && room == LOGGER_APPEND_BUFFER_SIZE && length >= LOGGER_APPEND_BUFFER_SIZE ) {
+			/* Aligned and nothing staged, write whole blocks straight from the caller's buffer. */
+			room = length - (length % LOGGER_APPEND_BUFFER_SIZE);
+			bytes_written = red_write(self->head_handle, data, (uint32_t) room);
+			if( RED_FILE_ERR == bytes_written ) {
+				lerr = LOGGER_NVMEM_ERR;
+				break;
+			}
+			self->head_size += (size_t) bytes_written;
+			logger_checksum_head(self, data, (size_t) bytes_written);
+			logger_count_element(self, self->head.sequence, (uint64_t) bytes_written);
+			if( (size_t) bytes_written < room ) {
+				lerr = LOGGER_NVMEM_FULL;
+				break;
+			}
+		} else {
+			if( room > length ) {
+				room = length;
+			}
+			memcpy(self->append_buffer + self->append_length, data, room);
+			self->append_length += room;
+			self->head_size += room;
+			logger_checksum_head(self, data, room);
+			if( (self->head_size % LOGGER_APPEND_BUFFER_SIZE) == 0 ) {
+				lerr = logger_flush_locked(self);
+				if( lerr != LOGGER_OK ) {
+					break;
+				}
+			}
+		}
+		data += room;
+		length -= room;
+	}
+
+	if( lerr != LOGGER_OK ) {
+		/* Nothing is staged after a failed write. Cut off the part of the record that made it */
+		/* to the file, so it is neither kept half written nor doubled by a retry. */
+		DEV_ASSERT(self->append_length == 0);
+		on_file = self->head_size;
+		if( on_file > start ) {
+			if( red_ftruncate(self->head_handle, (uint64_t) start) == RED_FILE_ERR ||
+				red_lseek(self->head_handle, (int64_t) start, RED_SEEK_SET) == RED_FILE_ERR ) {
+				/* Reopening seeks to the real end of the file. */
+				red_close(self->head_handle);
+				self->head_handle = RED_FILE_ERR;
+				self->head_size = 0;
+				if( self->byte_quota != 0 ) {
+					/* How much of the record is left is unknown, the byte count has to be rebuilt. */
+					self->occupancy_valid = MUTEX_FALSE;
+				}
+				return lerr;
+			}
+			logger_forget_element(self, self->head.sequence, (uint64_t) (on_file - start));
+			self->head_size = start;
+			self->head_crc = crc;
+			self->head_crc_valid = crc_valid;
+		}
+		return lerr;
+	}
+
+	if( self->byte_quota != 0 && self->bytes_stored > self->byte_quota ) {
+		lerr = logger_enforce_quota(self);
+	}
+	return lerr;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Queue a request for the writer task without blocking.
+ */
+static logger_error_t logger_submit( logger_request_t const* request )
+{
+	DEV_ASSERT(request);
+
+	if( logger_writer_queue == NULL ) {
+		/* start_logger_task( ) hasn't been called. */
+		return LOGGER_MUTEX_ERR;
+	}
+	if( xQueueSend(logger_writer_queue, request, 0) != pdTRUE ) {
+		return LOGGER_BUSY;
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Ask the writer task to do some upkeep for the logger, unless it has already been asked.
+ * @details
+ * 		Must hold the mutex. Nothing happens if start_logger_task( ) hasn't been called.
+ * @param op
+ * 		LOGGER_REQUEST_SWEEP or LOGGER_REQUEST_REFILL.
+ * @param queued[in/out]
+ * 		Flag set while the request is queued, cleared by the writer task.
+ */
+static void logger_submit_upkeep( logger_t* self, uint8_t op, bool_t* queued )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(queued);
+
+	logger_request_t request;
+
+	if( *queued ) {
+		return;
+	}
+	request.logger = self;
+	request.op = op;
+	request.file_name[0] = '\0';
+	request.buffer = NULL;
+	request.length = 0;
+	request.done = NULL;
+	request.arg = NULL;
+	if( logger_submit(&request) == LOGGER_OK ) {
+		*queued = MUTEX_TURE;
+	}
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Pop up to <b>max</b> elements without touching their files.
+ * @details
+ * 		Must hold the mutex. Used instead of renaming when logger_t::retire_mode isn't LOGGER_RETIRE_NOW.
+ * 		Holes are skipped using logger_t::occupancy and the TAIL is written once. The files are
+ * 		left for logger_sweep( ).
+ * @param names[out]
+ * 		Element names of the popped files, may be NULL.
+ */
+static logger_error_t logger_retire_locked( logger_t* self, size_t max, char names[][FILESYSTEM_MAX_NAME_LENGTH+1], size_t* popped )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(popped);
+
+	logger_error_t		lerr;
+	logger_position_t	tail, retired;
+	char				tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t			slot;
+	size_t				i = 0;
+
+	*popped = 0;
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+
+	tail = self->tail;
+	while( i < max && !logger_same_position(&tail, &self->head) ) {
+		slot = logger_find_slot(self, tail.sequence, self->head.sequence);
+		if( slot == self->max_capacity ) {
+			break;
+		}
+		logger_advance_position(self, &tail, (uint32_t) (slot >= tail.sequence ?
+												slot - tail.sequence :
+												self->max_capacity - tail.sequence + slot));
+		if( logger_same_position(&tail, &self->head) ) {
+			break;
+		}
+
+		logger_element_name(self, &tail, tail_file_name);
+		if( names != NULL ) {
+			memcpy(names[i], tail_file_name, FILESYSTEM_MAX_NAME_LENGTH+1);
+		}
+		if( self->byte_quota != 0 ) {
+			logger_forget_element(self, tail.sequence, logger_element_bytes(self, tail.sequence, tail_file_name));
+		}
+		logger_clear_slot(self, tail.sequence);
+		logger_next_position(self, &tail);
+		++i;
+	}
+
+	if( !logger_same_position(&tail, &self->tail) ) {
+		/* The popped elements stay behind the TAIL until swept. */
+		retired = self->retired;
+		lerr = logger_set_tail(self, &tail);
+		self->retired = retired;
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+	*popped = i;
+
+	if( logger_distance(self, &self->retired, &self->tail) >= LOGGER_SWEEP_BATCH ) {
+		logger_submit_upkeep(self, LOGGER_REQUEST_SWEEP, &self->sweep_queued);
+	}
+	return (i == 0) ? LOGGER_EMPTY : LOGGER_OK;
+}
+
+/* *****************************
+   Construct & Deconstruct func
+   ***************************** */
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Keep the loggers sharing a budget with this one within it.
+ * @details
+ * 		Must not hold the mutex, logger_quota_enforce( ) locks other loggers (and this one). Only
+ * 		enforces once the shared total is over the budget, otherwise no other lock is taken.
+ */
+static inline void logger_share_quota( logger_t* self )
+{
+	if( self->quota != NULL && logger_quota_exceeded(self->quota) ) {
+		logger_quota_enforce(self->quota);
+	}
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Create the lock shared by all logger instances, if it doesn't exist yet.
+ */
+static logger_error_t logger_create_fs_mutex( void )
+{
+	SemaphoreHandle_t candidate;
+
+	if( logger_fs_mutex != NULL ) {
+		return LOGGER_OK;
+	}
+
+	/* Two loggers may be initialized at the same time, only one mutex must win. */
+	candidate = xSemaphoreCreateMutex();
+	if( candidate == NULL ) {
+		return LOGGER_MUTEX_ERR;
+	}
+	taskENTER_CRITICAL();
+	if( logger_fs_mutex == NULL ) {
+		logger_fs_mutex = candidate;
+		candidate = NULL;
+	}
+	taskEXIT_CRITICAL();
+	if( candidate != NULL ) {
+		vSemaphoreDelete(candidate);
+	}
+	return LOGGER_OK;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Claim or release an element file name for a logger instance.
+ */
+static logger_error_t logger_register_name( char element_file_name, bool_t claim )
+{
+	uint8_t		name = (uint8_t) element_file_name;
+	uint32_t	mask = ((uint32_t) 1) << (name % 32);
+	logger_error_t lerr = LOGGER_OK;
+
+	lock_mutex(logger_fs_mutex);
+	if( !claim ) {
+		logger_element_names[name / 32] &= ~mask;
+	} else if( logger_element_names[name / 32] & mask ) {
+		lerr = LOGGER_INV_NAME;
+	} else {
+		logger_element_names[name / 32] |= mask;
+	}
+	unlock_mutex(logger_fs_mutex);
+	return lerr;
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Derive the name of a file kept next to the control file.
+ * @details
+ * 		<b>extension</b> is appended to the whole control file name, for example <b>ctrl.dat</b>
+ * 		is journaled in <b>ctrl.dat.jnl</b>, so control files that only differ in their extension
+ * 		don't share one.
+ */
+static void logger_sibling_name( logger_t* self, char const* extension, char* name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(extension);
+	DEV_ASSERT(name);
+
+	size_t length = strlen(self->control_file_name);
+	size_t extension_length = strlen(extension);
+
+	DEV_ASSERT(length + extension_length <= LOGGER_SIBLING_NAME_LENGTH);
+	memcpy(name, self->control_file_name, length);
+	memcpy(name + length, extension, extension_length + 1);
+}
+
+static void destroy( logger_t *self )
+{
+	DEV_ASSERT( self );
+
+	if( self->quota != NULL ) {
+		logger_quota_unregister(self->quota, self);
+	}
+
+	if( self->sync_mutex != NULL ) {
+		lock_mutex(self->sync_mutex);
+		logger_seal_head(self);
+		if( self->journal_interval != 0 && self->journal_records != 0 && self->control_data_cached ) {
+			/* Leave nothing to replay. */
+			logger_checkpoint(self, &self->head, &self->tail, self->popped_point);
+		}
+		unlock_mutex(self->sync_mutex);
+		vSemaphoreDelete(self->sync_mutex);
+		self->sync_mutex = NULL;
+		logger_register_name(self->element_file_name, MUTEX_FALSE);
+	}
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Shared by initialize_logger( ) and initialize_wide_logger( ), capacity has been checked.
+ */
+static logger_error_t logger_construct
+(
+	logger_t *self,
+	char const *control_file_name,
+	char element_file_name,
+	size_t max_capacity,
+	bool_t wide,
+	uint32_t* occupancy,
+	size_t occupancy_words
+)
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( control_file_name );
+	DEV_ASSERT( occupancy );
+
+	logger_error_t lerr;
+
+	/* Link virtual methods. */
+	self->destroy = destroy;
+	self->sync_mutex = NULL;
+	self->control_version = 0;
+	self->head_handle = RED_FILE_ERR;
+	self->head_size = 0;
+	self->head_rotate = MUTEX_FALSE;
+	self->append_length = 0;
+	self->rotate_size = 0;
+	self->rotate_age = 0;
+
+	/* Setup Member data. */
+	//self->fs = filesystem;
+	self->element_file_name = element_file_name;
+	self->max_capacity = max_capacity;
+	self->wide = wide;
+	self->occupancy = occupancy;
+	self->occupancy_words = occupancy_words;
+	self->head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+	self->tail_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+
+	/* Copy control file name into logger instance. */
+	strncpy( self->control_file_name, control_file_name, FILESYSTEM_MAX_NAME_LENGTH );
+	self->control_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0'; /* Fail safe. */
+	logger_sibling_name(self, LOGGER_JOURNAL_EXTENSION, self->journal_file_name);
+	logger_sibling_name(self, LOGGER_INDEX_EXTENSION, self->index_file_name);
+	self->time_source = NULL;
+	logger_sibling_name(self, LOGGER_CHECKSUM_EXTENSION, self->checksum_file_name);
+	self->checksums = MUTEX_FALSE;
+	self->head_crc = LOGGER_CRC32_INIT;
+	self->head_crc_valid = MUTEX_FALSE;
+	self->journal_interval = 0;
+	self->journal_records = 0;
+	self->byte_quota = 0;
+	self->bytes_stored = 0;
+	self->element_bytes = NULL;
+	self->quota = NULL;
+	self->retire_mode = LOGGER_RETIRE_NOW;
+	self->sweep_queued = MUTEX_FALSE;
+	self->pool_size = 0;
+	self->pool_ready = 0;
+	self->pool_queued = MUTEX_FALSE;
+
+	/* Shared lock, then this instance's claim on its element name and its own mutex. */
+	lerr = logger_create_fs_mutex();
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	lerr = logger_register_name(element_file_name, MUTEX_TURE);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	self->sync_mutex = xSemaphoreCreateMutex();
+	if( self->sync_mutex == NULL ) {
+		logger_register_name(element_file_name, MUTEX_FALSE);
+		return LOGGER_MUTEX_ERR;
+	}
+
+	/* Cache control data within the control data file. From here on logger_t owns the control data. */
+	self->control_data_cached = MUTEX_FALSE;
+	self->occupancy_valid = MUTEX_FALSE;
+	lerr = logger_cache_control_data(self);
+	if( lerr == LOGGER_OK ) {
+		/* One directory scan up front, rather than on the first tail repair. */
+		lerr = logger_scan_occupancy(self);
+	}
+	if( lerr != LOGGER_OK ) {
+		destroy(self);
+	}
+	return lerr;
+}
+
+logger_error_t initialize_logger
+(
+	logger_t *self,
+	//FILE *filesystem,
+	char const *control_file_name,
+	char element_file_name,
+	size_t max_capacity
+)
+{
+	DEV_ASSERT( self );
+	//DEV_ASSERT( filesystem );
+
+	if( max_capacity > LOGGER_MAX_CAPACITY || max_capacity < LOGGER_MIN_CAPCITY ) {
+		return LOGGER_INV_CAP;
+	}
+	return logger_construct(self, control_file_name, element_file_name, max_capacity,
+							MUTEX_FALSE, self->occupancy_storage, LOGGER_OCCUPANCY_WORDS);
+}
+
+logger_error_t initialize_wide_logger
+(
+	logger_t *self,
+	char const *control_file_name,
+	char element_file_name,
+	size_t max_capacity,
+	uint32_t* occupancy,
+	size_t occupancy_words
+)
+{
+	DEV_ASSERT( self );
+
+	if( max_capacity > LOGGER_WIDE_MAX_CAPACITY || max_capacity < LOGGER_MIN_CAPCITY ) {
+		return LOGGER_INV_CAP;
+	}
+	if( occupancy == NULL || occupancy_words < (max_capacity + 31) / 32 ) {
+		return LOGGER_INV_CAP;
+	}
+	return logger_construct(self, control_file_name, element_file_name, max_capacity,
+							MUTEX_TURE, occupancy, occupancy_words);
+}
+
+
+
+/********************************************************************************/
+/* Public Method Definitions													*/
+/********************************************************************************/
+int32_t logger_peek_head( logger_t* self, logger_error_t* err )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( err );
+
+	int32_t			head_file_handle;
+	int64_t			file_err;
+	logger_error_t	logger_err;
+	char			head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+
+	/* Get name of file at HEAD. Only take the mutex if the lock free read fails. */
+	if( !logger_read_name(self, self->head_file_name, head_file_name) ) {
+		lock_mutex( self->sync_mutex);
+		logger_get_head(self, &logger_err);
+		memcpy(head_file_name, self->head_file_name, FILESYSTEM_MAX_NAME_LENGTH+1);
+		unlock_mutex( self->sync_mutex );
+		if( logger_err != LOGGER_OK ) {
+			*err = logger_err;
+			return RED_FILE_ERR;
+		}
+	}
+
+	/* Open the file. */
+	head_file_handle = red_open(head_file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == head_file_handle ) {
+		*err = LOGGER_EMPTY;
+		return RED_FILE_ERR;
+	}
+
+	/* Seek to the end of the file. */
+	file_err = red_lseek(head_file_handle, 0, RED_SEEK_END);
+	if( RED_FILE_ERR == file_err ) {
+		*err = LOGGER_NVMEM_ERR;
+		red_close(head_file_handle);
+		return RED_FILE_ERR;
+	}
+	*err = LOGGER_OK;
+	return head_file_handle;
+}
+
+/* Insert a given filename as head name 
+   NOte: Only rename new file name to current head name*/
+int32_t logger_insert( logger_t* self, logger_error_t* err, char const* file_to_insert_name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(err);
+
+	int32_t			head_file_handle;
+
+	lock_mutex(self->sync_mutex);
+	head_file_handle = logger_insert_locked(self, err, file_to_insert_name);
+	unlock_mutex( self->sync_mutex );
+	if( RED_FILE_ERR == head_file_handle ) {
+		return RED_FILE_ERR;
+	}
+	red_close(head_file_handle);
+	logger_share_quota(self);
+	return head_file_handle;
+}
+
+logger_error_t logger_insert_batch( logger_t* self, char const* const file_names[], size_t count, size_t* inserted )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(file_names);
+
+	logger_error_t lerr;
+
+	if( inserted != NULL ) {
+		*inserted = 0;
+	}
+	if( count == 0 ) {
+		return LOGGER_OK;
+	}
+
+	lock_mutex(self->sync_mutex);
+	lerr = logger_insert_batch_locked(self, file_names, count, inserted);
+	unlock_mutex(self->sync_mutex);
+	logger_share_quota(self);
+	return lerr;
+}
+
+/**/
+int32_t logger_peek_tail( logger_t* self, logger_error_t* err )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( err );
+
+	int32_t 	tail_file_handle;
+	char const* tail_file_name;
+	char		tail_copy[FILESYSTEM_MAX_NAME_LENGTH+1];
+
+	/* Common case: the TAIL is cached and its file exists, no need for the mutex. */
+	if( logger_read_name(self, self->tail_file_name, tail_copy) ) {
+		tail_file_handle = red_open(tail_copy, RED_O_RDWR);
+		if( RED_FILE_ERR != tail_file_handle ) {
+			*err = LOGGER_OK;
+			return tail_file_handle;
+		}
+	}
+
+	/* The TAIL may need to be moved, that is a structural change. */
+	lock_mutex( self->sync_mutex);
+
+	/* Get name of tail. */
+	logger_get_tail(self, err);
+	tail_file_name = self->tail_file_name;
+	if( *err != LOGGER_OK ) {
+		unlock_mutex(self->sync_mutex);
+		return RED_FILE_ERR;
+	}
+
+	/* Open tail file. */
+	tail_file_handle = red_open(tail_file_name, RED_O_RDWR);
+	if( RED_FILE_ERR == tail_file_handle ) {
+		/* Tail needs to be updated. The cached name follows the update. */
+		*err = logger_update_tail(self);
+		if( *err != LOGGER_OK ) {
+			unlock_mutex(self->sync_mutex);
+			return RED_FILE_ERR;
+		}
+
+		/* Updated tail, try opening the file again. */
+		tail_file_handle = red_open(tail_file_name, RED_O_RDONLY);
+	}
+	/*Check if the tail file is updated successfully*/
+	if( RED_FILE_ERR == tail_file_handle ) {
+		*err = LOGGER_NVMEM_ERR;
+		unlock_mutex(self->sync_mutex);
+		return RED_FILE_ERR;
+	}
+	*err = LOGGER_OK;
+	unlock_mutex( self->sync_mutex );
+	return tail_file_handle;
+}
+
+/* Open the element <b>index</b> places after the TAIL, read only. */
+int32_t logger_peek_at( logger_t* self, size_t index, logger_error_t* err )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( err );
+
+	logger_position_t	position;
+	char				file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	int32_t				file_handle;
+
+	lock_mutex( self->sync_mutex );
+	*err = logger_require_occupancy(self);
+	if( *err != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return RED_FILE_ERR;
+	}
+	if( index > logger_distance(self, &self->tail, &self->head) ) {
+		unlock_mutex( self->sync_mutex );
+		*err = LOGGER_EMPTY;
+		return RED_FILE_ERR;
+	}
+
+	position = self->tail;
+	logger_advance_position(self, &position, (uint32_t) index);
+	logger_element_name(self, &position, file_name);
+	unlock_mutex( self->sync_mutex );
+
+	file_handle = red_open(file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == file_handle ) {
+		*err = LOGGER_EMPTY;
+		return RED_FILE_ERR;
+	}
+	*err = LOGGER_OK;
+	return file_handle;
+}
+
+logger_error_t logger_iterate( logger_t* self, logger_iterator_t* iterator, bool_t from_head )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( iterator );
+
+	logger_error_t lerr;
+
+	iterator->logger = self;
+	iterator->remaining = 0;
+	iterator->forward = !from_head;
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_require_occupancy(self);
+	if( lerr == LOGGER_OK ) {
+		iterator->position = from_head ? self->head : self->tail;
+		iterator->remaining = (uint32_t) logger_distance(self, &self->tail, &self->head) + 1;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_iterator_next( logger_iterator_t* iterator, char* file_name )
+{
+	DEV_ASSERT( iterator );
+	DEV_ASSERT( file_name );
+
+	logger_t*			self = iterator->logger;
+	logger_position_t	candidate;
+	logger_error_t		lerr;
+	uint32_t			last, slot, gap;
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	lerr = LOGGER_EMPTY;
+	while( iterator->remaining > 0 ) {
+		/* Jump straight to the next live slot in what's left of the span. */
+		if( iterator->forward ) {
+			last = (uint32_t) ((iterator->position.sequence + iterator->remaining - 1) % self->max_capacity);
+			slot = logger_find_slot(self, iterator->position.sequence, last);
+		} else {
+			last = (uint32_t) ((iterator->position.sequence + self->max_capacity - ((iterator->remaining - 1) % self->max_capacity)) % self->max_capacity);
+			slot = logger_find_slot_reverse(self, iterator->position.sequence, last);
+		}
+		if( slot == self->max_capacity ) {
+			iterator->remaining = 0;
+			break;
+		}
+		if( iterator->forward ) {
+			gap = (slot >= iterator->position.sequence) ? slot - iterator->position.sequence : (uint32_t) self->max_capacity - iterator->position.sequence + slot;
+			logger_advance_position(self, &iterator->position, gap);
+		} else {
+			gap = (slot <= iterator->position.sequence) ? iterator->position.sequence - slot : iterator->position.sequence + (uint32_t) self->max_capacity - slot;
+			logger_retreat_position(self, &iterator->position, gap);
+		}
+
+		candidate = iterator->position;
+		iterator->remaining -= gap + 1;
+		if( iterator->forward ) {
+			logger_next_position(self, &iterator->position);
+		} else {
+			logger_retreat_position(self, &iterator->position, 1);
+		}
+
+		/* The slot may since have been reused by a newer element. */
+		if( logger_is_live(self, &candidate) ) {
+			logger_element_name(self, &candidate, file_name);
+			lerr = LOGGER_OK;
+			break;
+		}
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+/*pop a filename from log file that alreadly existed in*/
+logger_error_t logger_pop( logger_t* self, char* popped_file_name )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t 	lerr;
+	char			tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	char			retired_name[1][FILESYSTEM_MAX_NAME_LENGTH+1];
+	size_t			popped;
+	//uint32_t		fs_err;
+	int32_t			tail_file_handle;
+	uint64_t		bytes = 0;
+
+	lock_mutex( self->sync_mutex);
+
+	/* Get the TAIL file. */
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	if( self->retire_mode != LOGGER_RETIRE_NOW ) {
+		/* Only move the TAIL, the file is left for logger_sweep( ). */
+		lerr = logger_retire_locked(self, 1, retired_name, &popped);
+		unlock_mutex( self->sync_mutex );
+		if( lerr == LOGGER_OK && popped_file_name != NULL ) {
+			memcpy(popped_file_name, retired_name[0], FILESYSTEM_MAX_NAME_LENGTH+1);
+		}
+		return lerr;
+	}
+
+	/* Check if this file exists, if not, we have to update the TAIL. */
+	tail_file_handle = red_open(self->tail_file_name, RED_O_RDWR);
+	if( RED_FILE_ERR == tail_file_handle ) {
+		/* File doesn't exist, so update TAIL. */
+		lerr = logger_update_tail(self);
+		if( lerr != LOGGER_OK ) {
+			unlock_mutex( self->sync_mutex );
+			return lerr;
+		}
+	} else {
+		red_close(tail_file_handle);
+	}
+	// else if( fs_err != FS_OK ) {
+	// 	/* Failed to check for file existance. */
+	// 	//unlock_mutex( self->sync_mutex );
+	// 	return LOGGER_NVMEM_ERR;
+	// }
 
-			/* No file, and HEAD != TAIL, keep searching for the current TAIL. */
-			logger_next_name(self, tail_file_name);
-		} else {
-			/* Element has a file. */
-			do_update = true;
+	/* Check if this is the HEAD file. If it is, don't touch it. */
+	if( logger_same_position(&self->head, &self->tail) ) {
+		/* HEAD == TAIL, don't untrack head.. */
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_EMPTY;
+	}
+
+	/* We're removing this file from the ring buffer tracking, so untrack the file. */
+	/* This operation just renames it. */
+	memcpy(tail_file_name, self->tail_file_name, FILESYSTEM_MAX_NAME_LENGTH+1);
+	if( self->byte_quota != 0 ) {
+		bytes = logger_element_bytes(self, self->tail.sequence, tail_file_name);
+	}
+	lerr = logger_untrack_file(self, tail_file_name);
+	if( lerr != LOGGER_OK ) {
+		/* Failed to untrack the file. */
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+	logger_forget_element(self, self->tail.sequence, bytes);
+	logger_clear_slot(self, self->tail.sequence);
+
+	/* Got the file that is going to be removed, copy it into input buffer. */
+	 if( popped_file_name != NULL ) {
+
+		/* Copy name of popped file into here. */
+		strncpy(popped_file_name, tail_file_name, FILESYSTEM_MAX_NAME_LENGTH);
+		popped_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+	} 
+
+	/* Update the TAIL. */
+	lerr = logger_update_tail(self);
+	
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+/**
+ * @memberof logger_t
+ * @brief
+ * 		Pop a run of up to <b>max</b> files from the TAIL with a single TAIL write.
+ * @details
+ * 		Like logger_pop( ), the TAIL is moved over any holes left past the run afterwards.
+ */
+logger_error_t logger_pop_n( logger_t* self, size_t max, char popped_file_names[][FILESYSTEM_MAX_NAME_LENGTH+1], size_t* popped )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( popped );
+
+	logger_error_t 		lerr, commit_err;
+	logger_position_t	tail;
+	char				tail_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	char				new_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t			first_point, point;
+	uint64_t			bytes = 0;
+	size_t				count;
+	size_t				i;
+
+	*popped = 0;
+	if( max == 0 ) {
+		return LOGGER_OK;
+	}
+
+	lock_mutex( self->sync_mutex );
+
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	if( self->retire_mode != LOGGER_RETIRE_NOW ) {
+		lerr = logger_retire_locked(self, max, popped_file_names, popped);
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	/* There can't be more files to pop than elements between TAIL and HEAD. */
+	count = logger_distance(self, &self->tail, &self->head);
+	if( count < max ) {
+		max = count;
+	}
+	if( max == 0 ) {
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_EMPTY;
+	}
+
+	/* Reserve the popped temporal points for the whole run with one write, before any file */
+	/* takes one of the names. Points left unused by holes are simply skipped. */
+	first_point = (self->popped_point + 1) % LOGGER_MAX_POPPED_POINTS;
+	lerr = logger_set_popped_point(self, first_point + (uint32_t) max - 1);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	tail = self->tail;
+	point = first_point;
+	i = 0;
+	while( i < max ) {
+		if( logger_same_position(&self->head, &tail) ) {
+			/* HEAD == TAIL, don't untrack head.. */
 			break;
-		} 
-		// else {
-		// 	/* Some file system error. */
-		// 	return LOGGER_NVMEM_ERR;
-		// }
+		}
+
+		logger_element_name(self, &tail, tail_file_name);
+		logger_popped_name(self, point, new_name);
+		if( self->byte_quota != 0 ) {
+			bytes = logger_element_bytes(self, tail.sequence, tail_file_name);
+		}
+		if( RED_FILE_ERR == logger_rename_over(tail_file_name, new_name) ) {
+			if( red_errno != RED_ENOENT ) {
+				lerr = LOGGER_NVMEM_ERR;
+				break;
+			}
+			/* Asynchronously removed, step over the hole. */
+		} else {
+			if( popped_file_names != NULL ) {
+				memcpy(popped_file_names[i], new_name, FILESYSTEM_MAX_NAME_LENGTH+1);
+			}
+			logger_forget_element(self, tail.sequence, bytes);
+			++i;
+			++point;
+		}
+		logger_clear_slot(self, tail.sequence);
+		logger_next_position(self, &tail);
 	}
 
-	if( do_update ) {
-		/* Update the tail meta data. */
-		return logger_set_tail(self, tail_file_name);
+	/* Persist the new TAIL once. */
+	commit_err = LOGGER_OK;
+	if( !logger_same_position(&tail, &self->tail) ) {
+		commit_err = logger_set_tail(self, &tail);
+	}
+
+	/* Update the TAIL, an emptied buffer is not an error here. */
+	if( commit_err == LOGGER_OK ) {
+		commit_err = logger_update_tail(self);
+		if( commit_err == LOGGER_EMPTY ) {
+			commit_err = LOGGER_OK;
+		}
+	}
+	unlock_mutex( self->sync_mutex );
+
+	*popped = i;
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	if( commit_err != LOGGER_OK ) {
+		return commit_err;
+	}
+	return (i == 0) ? LOGGER_EMPTY : LOGGER_OK;
+}
+
+/* Drop the cached control data and read it back from the control file. */
+logger_error_t logger_revalidate( logger_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
+
+	lock_mutex( self->sync_mutex );
+	logger_seal_head(self);
+	self->control_data_cached = MUTEX_FALSE;
+	lerr = logger_cache_control_data(self);
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_drop_tail( logger_t* self, uint64_t* freed )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( freed );
+
+	logger_error_t		lerr;
+	logger_position_t	tail;
+	uint64_t			before;
+
+	*freed = 0;
+	lock_mutex( self->sync_mutex );
+
+	/* Skip over holes first, so a file is actually deleted. */
+	lerr = logger_update_tail(self);
+	if( lerr == LOGGER_OK && logger_same_position(&self->head, &self->tail) ) {
+		lerr = LOGGER_EMPTY;
+	}
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	/* Bytes may have to be recounted if update_tail found holes. */
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+
+	tail = self->tail;
+	before = self->bytes_stored;
+	lerr = logger_remove_tail(self, &tail);
+	if( lerr == LOGGER_OK ) {
+		lerr = logger_set_tail(self, &tail);
+	}
+	*freed = before - self->bytes_stored;
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_set_journal( logger_t* self, uint32_t checkpoint_interval )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr = LOGGER_OK;
+
+	lock_mutex( self->sync_mutex );
+	if( checkpoint_interval == 0 && self->journal_interval != 0 ) {
+		/* Back to writing the control file directly, fold the journal in first. */
+		lerr = logger_require_control_data(self);
+		if( lerr == LOGGER_OK ) {
+			lerr = logger_checkpoint(self, &self->head, &self->tail, self->popped_point);
+		}
+	}
+	if( lerr == LOGGER_OK ) {
+		self->journal_interval = checkpoint_interval;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+void logger_set_time_source( logger_t* self, logger_time_source_t source )
+{
+	DEV_ASSERT( self );
+
+	lock_mutex( self->sync_mutex );
+	self->time_source = source;
+	unlock_mutex( self->sync_mutex );
+}
+
+logger_error_t logger_find_range( logger_t* self, uint32_t start, uint32_t end, size_t* first, size_t* count )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( first );
+	DEV_ASSERT( count );
+
+	logger_error_t	lerr;
+	int32_t			index_handle;
+	uint32_t		elements, low, high;
+
+	*first = 0;
+	*count = 0;
+	if( start > end ) {
+		return LOGGER_EMPTY;
+	}
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_require_control_data(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+	index_handle = red_open(self->index_file_name, RED_O_RDONLY);
+	if( RED_FILE_ERR == index_handle ) {
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_EMPTY;
+	}
+
+	elements = (uint32_t) logger_distance(self, &self->tail, &self->head) + 1;
+	low = logger_index_search(self, index_handle, 0, elements, start);
+	high = elements;
+	if( end != ~(uint32_t) 0 ) {
+		high = logger_index_search(self, index_handle, low, elements, end + 1);
+	}
+	red_close(index_handle);
+	unlock_mutex( self->sync_mutex );
+
+	if( low >= high ) {
+		return LOGGER_EMPTY;
 	}
+	*first = low;
+	*count = high - low;
 	return LOGGER_OK;
 }
 
-/* *****************************
-   Construct & Deconstruct func
-   ***************************** */
-static void destroy( logger_t *self )
+void logger_set_checksums( logger_t* self, bool_t enable )
 {
 	DEV_ASSERT( self );
+
+	lock_mutex( self->sync_mutex );
+	if( enable && !self->checksums ) {
+		/* Only an empty HEAD can be followed from here, otherwise wait for the next element. */
+		self->head_crc = LOGGER_CRC32_INIT;
+		self->head_crc_valid = (self->head_handle == RED_FILE_ERR || self->head_size == 0) ? MUTEX_TURE : MUTEX_FALSE;
+	}
+	self->checksums = enable;
+	unlock_mutex( self->sync_mutex );
 }
 
-logger_error_t initialize_logger
-(
-	logger_t *self,
-	//FILE *filesystem,
-	char const *control_file_name,
-	char element_file_name,
-	size_t max_capacity,
-	bool_t logger_is_init
-)
+logger_error_t logger_element_checksum( logger_t* self, size_t index, uint32_t* crc, uint32_t* length )
 {
-	
 	DEV_ASSERT( self );
-	//DEV_ASSERT( filesystem );
-	DEV_ASSERT( control_file_name );
-	/* Link virtual methods. */
-	self->destroy = destroy;
+	DEV_ASSERT( crc );
+	DEV_ASSERT( length );
+
+	logger_position_t	position;
+	char				file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	logger_error_t		lerr;
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_require_occupancy(self);
+	if( lerr != LOGGER_OK ) {
+		unlock_mutex( self->sync_mutex );
+		return lerr;
+	}
+	if( index > logger_distance(self, &self->tail, &self->head) ) {
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_EMPTY;
+	}
+	position = self->tail;
+	logger_advance_position(self, &position, (uint32_t) index);
+	logger_element_name(self, &position, file_name);
 
-	/* Initialize singleton mutex. */
-	if( logger_is_init == MUTEX_FALSE ) {
-		logger_sync_mutex = xSemaphoreCreateMutex();
-		if( logger_sync_mutex == NULL ) {
-			return LOGGER_MUTEX_ERR;
+	if( self->head_handle != RED_FILE_ERR && logger_same_position(&position, &self->head) ) {
+		/* The open HEAD, still being appended to. */
+		lerr = logger_flush_locked(self);
+		if( lerr == LOGGER_OK && !(self->checksums && self->head_crc_valid) ) {
+			lerr = logger_checksum_file(file_name, &self->head_crc, length);
+			self->head_crc_valid = (lerr == LOGGER_OK && *length == (uint32_t) self->head_size) ? MUTEX_TURE : MUTEX_FALSE;
 		}
-		logger_is_init = MUTEX_TURE;
-		/* Delete */
-		xSemaphoreGive( logger_sync_mutex );
+		*crc = self->head_crc;
+		*length = (uint32_t) self->head_size;
+		unlock_mutex( self->sync_mutex );
+		return lerr;
 	}
 
-	/* Setup Member data. */
-	//self->fs = filesystem;
-	self->sync_mutex = &logger_sync_mutex;
-	self->element_file_name = element_file_name;
-	if( max_capacity > LOGGER_MAX_CAPACITY || max_capacity < LOGGER_MIN_CAPCITY ) {
+	/* Records are only trusted while the element is still as long as it was. */
+	if( logger_checksum_lookup(self, &position, crc, length) && logger_file_bytes(file_name) == *length ) {
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_OK;
+	}
+	unlock_mutex( self->sync_mutex );
+
+	lerr = logger_checksum_file(file_name, crc, length);
+	if( lerr == LOGGER_OK ) {
+		/* The element may have been popped, and its slot reused, while it was read. */
+		lock_mutex( self->sync_mutex );
+		if( self->checksums && logger_require_occupancy(self) == LOGGER_OK && logger_is_live(self, &position) ) {
+			logger_record_checksum(self, &position, *crc, *length);
+		}
+		unlock_mutex( self->sync_mutex );
+	}
+	return lerr;
+}
+
+logger_error_t logger_set_pool( logger_t* self, size_t size )
+{
+	DEV_ASSERT( self );
+
+	char			pool_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	uint32_t		index;
+	logger_error_t	lerr;
+
+	if( size > LOGGER_POOL_MAX ) {
+		size = LOGGER_POOL_MAX;
+	}
+
+	lock_mutex( self->sync_mutex );
+	/* Give back what no longer fits. */
+	for( index = (uint32_t) size; index < self->pool_size; ++index ) {
+		if( self->pool_ready & ((uint32_t) 1 << index) ) {
+			logger_pool_name(self, index, pool_file_name);
+			red_unlink(pool_file_name);
+			self->pool_ready &= ~((uint32_t) 1 << index);
+		}
+	}
+	self->pool_size = size;
+	lerr = logger_fill_pool_locked(self);
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_fill_pool( logger_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_fill_pool_locked(self);
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_set_retire( logger_t* self, logger_retire_t mode )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr = LOGGER_OK;
+
+	lock_mutex( self->sync_mutex );
+	if( mode == LOGGER_RETIRE_NOW ) {
+		/* Nothing is left waiting once popping is eager again. */
+		lerr = logger_require_occupancy(self);
+		if( lerr == LOGGER_OK ) {
+			lerr = logger_sweep_locked(self, self->max_capacity, NULL);
+		}
+	}
+	if( lerr == LOGGER_OK ) {
+		self->retire_mode = mode;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_sweep( logger_t* self, size_t max, size_t* swept )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_require_occupancy(self);
+	if( lerr == LOGGER_OK ) {
+		lerr = logger_sweep_locked(self, max, swept);
+	} else if( swept != NULL ) {
+		*swept = 0;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_set_quota( logger_t* self, uint64_t max_bytes )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr = LOGGER_OK;
+
+	lock_mutex( self->sync_mutex );
+	if( self->byte_quota == 0 && max_bytes != 0 ) {
+		/* Bytes aren't counted without a quota, rebuild the count. */
+		self->occupancy_valid = MUTEX_FALSE;
+	}
+	self->byte_quota = max_bytes;
+	if( max_bytes != 0 ) {
+		lerr = logger_enforce_quota(self);
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
+}
+
+logger_error_t logger_set_size_table( logger_t* self, uint32_t* sizes, size_t entries )
+{
+	DEV_ASSERT( self );
+
+	if( sizes != NULL && entries < self->max_capacity ) {
 		return LOGGER_INV_CAP;
 	}
-	self->max_capacity = max_capacity;
-	self->head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '00010000.log';
-	self->tail_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '00010000.log';
 
-    /*strncpy( self->head_file_name, '00010000.log', FILESYSTEM_MAX_NAME_LENGTH );
-    self->head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
-    strncpy( self->tail_file_name, '00010000.log', FILESYSTEM_MAX_NAME_LENGTH );
-    self->tail_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';*/
-	/* Copy control file name into logger instance. */
-	strncpy( self->control_file_name, control_file_name, FILESYSTEM_MAX_NAME_LENGTH );
-	self->control_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0'; /* Fail safe. */
+	lock_mutex( self->sync_mutex );
+	self->element_bytes = sizes;
+	if( sizes != NULL ) {
+		/* Filled in by the next scan. */
+		self->occupancy_valid = MUTEX_FALSE;
+	}
+	unlock_mutex( self->sync_mutex );
+	return LOGGER_OK;
+}
 
-	/* Cache control data within the control data file. */
-	return logger_cache_control_data(self);
+uint64_t logger_bytes_stored( logger_t* self )
+{
+	DEV_ASSERT( self );
+
+	uint64_t bytes;
+
+	lock_mutex( self->sync_mutex );
+	bytes = self->bytes_stored;
+	unlock_mutex( self->sync_mutex );
+	return bytes;
 }
 
+void logger_set_rotation( logger_t* self, size_t max_element_size, TickType_t max_element_age )
+{
+	DEV_ASSERT( self );
+
+	lock_mutex( self->sync_mutex );
+	self->rotate_size = max_element_size;
+	self->rotate_age = max_element_age;
+	unlock_mutex( self->sync_mutex );
+}
+
+logger_error_t logger_append( logger_t* self, void const* buffer, size_t length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( buffer || length == 0 );
+
+	logger_error_t	lerr;
+
+	if( length == 0 ) {
+		return LOGGER_OK;
+	}
+
+	lock_mutex( self->sync_mutex );
+	lerr = logger_append_locked(self, buffer, length);
+	unlock_mutex( self->sync_mutex );
+	logger_share_quota(self);
+	return lerr;
+}
+
+logger_error_t logger_flush( logger_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
 
+	lock_mutex( self->sync_mutex );
+	if( logger_needs_rotation(self, 0) ) {
+		/* Also close off an element that has aged out. */
+		lerr = logger_seal_head(self);
+		self->head_rotate = MUTEX_TURE;
+	} else {
+		lerr = logger_flush_locked(self);
+	}
+	unlock_mutex( self->sync_mutex );
+	logger_share_quota(self);
+	return lerr;
+}
 
-/********************************************************************************/
-/* Public Method Definitions													*/
-/********************************************************************************/
-int32_t logger_peek_head( logger_t* self, logger_error_t* err )
+logger_error_t logger_rotate( logger_t* self )
 {
 	DEV_ASSERT( self );
-	DEV_ASSERT( err );
 
-	int32_t			head_file_handle;
-	int64_t		file_err;
-	logger_error_t	logger_err;
-	char const*		head_file_name;
-	//ssize_t			eof;
-	REDSTAT    		*pStat;
+	logger_error_t lerr = LOGGER_OK;
 
-	lock_mutex( *self->sync_mutex);
-
-	/* Get name of file at HEAD. */
-	head_file_name = logger_get_head(self, &logger_err);
-	if( logger_err != LOGGER_OK ) {
-		unlock_mutex( *self->sync_mutex );
-		return GET_NULL_FILE;
+	lock_mutex( self->sync_mutex );
+	if( self->head_handle != RED_FILE_ERR ) {
+		lerr = logger_seal_head(self);
+		self->head_rotate = MUTEX_TURE;
 	}
+	unlock_mutex( self->sync_mutex );
+	logger_share_quota(self);
+	return lerr;
+}
 
-	/* Open the file. */
-	head_file_handle = red_open(head_file_name, RED_O_RDONLY);
-	unlock_mutex( *self->sync_mutex );
-	if( RED_FILE_ERR == head_file_handle ) {
-		*err = LOGGER_EMPTY;
-		return GET_NULL_FILE;
-	}
+logger_error_t logger_cursor_open( logger_t* self, logger_cursor_t* cursor )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( cursor );
 
-	/* Get size of the file so we can seek to the end of it. */
-	if(red_fstat(head_file_handle, pStat) != 0){
-		*err = LOGGER_NVMEM_ERR;
-		red_close(head_file_handle);
-		return GET_NULL_FILE;
-	}
+	logger_error_t lerr = LOGGER_OK;
 
-	/* Seek to the end of the file. */
-	file_err = red_lseek(head_file_handle, pStat->st_size, RED_SEEK_SET);
-	if( RED_FILE_ERR == file_err ) {
-		*err = LOGGER_NVMEM_ERR;
-		red_close(head_file_handle);
-		return GET_NULL_FILE;
+	cursor->logger = self;
+	cursor->offset = 0;
+
+	lock_mutex( self->sync_mutex );
+	if( self->head_handle == RED_FILE_ERR ) {
+		lerr = logger_open_head(self, MUTEX_FALSE);
 	}
-	*err = LOGGER_OK;
-	return head_file_handle;
+	if( lerr == LOGGER_OK ) {
+		cursor->element = self->head;
+		cursor->offset = self->head_size;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
 }
 
-/* Insert a given filename as head name 
-   NOte: Only rename new file name to current head name*/
-int32_t logger_insert( logger_t* self, logger_error_t* err, char const* file_to_insert_name )
+logger_error_t logger_cursor_write( logger_cursor_t* cursor, void const* buffer, size_t length )
 {
-	DEV_ASSERT(self);
-	DEV_ASSERT(err);
+	DEV_ASSERT( cursor );
+	DEV_ASSERT( buffer || length == 0 );
 
-	logger_error_t 	lerr;
-	uint32_t		fs_err;
-	char* 			head_file_name;
-	char*			tail_file_name;
-	char			new_head_file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
-	int32_t			head_file_handle;
+	logger_t*		self = cursor->logger;
+	logger_error_t	lerr;
 
-	lock_mutex(*self->sync_mutex);
-	/* Get the name (position) of the HEAD and TAIL. */
-	head_file_name = logger_get_head(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		unlock_mutex(*self->sync_mutex);
-		*err = lerr;
-		return GET_NULL_FILE;
+	if( length == 0 ) {
+		return LOGGER_OK;
 	}
-	if( (head_file_handle = red_open(head_file_name, RED_O_RDONLY)) == RED_FILE_ERR ) {
-		/* The HEAD file doesn't exist => logger emptied via asynchronous file removal. */
-		lerr = logger_create_control_file(self); /* FIXME: only reset head/tail pointers - not temporal data too */
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			*err = lerr;
-			return GET_NULL_FILE;
-		}
-		head_file_name = logger_get_head(self, &lerr);
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			*err = lerr;
-			return GET_NULL_FILE;
-		}
-	}else{red_close(head_file_handle);}
 
-	tail_file_name = logger_get_tail(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		unlock_mutex(*self->sync_mutex);
-		*err = lerr;
-		return GET_NULL_FILE;
+	lock_mutex( self->sync_mutex );
+	lerr = logger_append_locked(self, buffer, length);
+	if( lerr == LOGGER_OK ) {
+		/* Rotation happens before the record is staged, so it is all in the HEAD. */
+		cursor->element = self->head;
+		cursor->offset = self->head_size - length;
 	}
-	/* Increment HEAD to next element. */
-	logger_next_name(self, head_file_name);
+	unlock_mutex( self->sync_mutex );
+	logger_share_quota(self);
+	return lerr;
+}
 
-	/* Check if HEAD == TAIL. To do this, we only need to look at the sequencing bytes (first three bytes). */
-	if( strncmp(tail_file_name, head_file_name, LOGGER_TOTAL_SEQUENCE_BYTES) == 0 ) {
-		/* HEAD and TAIL are overlapping. */
-		/* Since asynchronous file removals can happen, lets first update position of the TAIL and then see if */
-		/* the HEAD and TAIL still overlap. */
-		lerr = logger_update_tail(self);
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			*err = lerr;
-			return GET_NULL_FILE;
-		}
+logger_error_t logger_cursor_truncate( logger_cursor_t* cursor, size_t offset )
+{
+	DEV_ASSERT( cursor );
 
-		/* Get new TAIL. */
-		tail_file_name = logger_get_tail(self, &lerr);
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			*err = lerr;
-			return GET_NULL_FILE;
-		}
-		/* Since get tail method refreshes cache - the cached head name is also refreshed so must recall next name method. */
-		logger_next_name(self, head_file_name);
+	logger_t*		self = cursor->logger;
+	logger_error_t	lerr = LOGGER_OK;
+	size_t			on_file;
 
-		if( strncmp(tail_file_name, head_file_name, LOGGER_TOTAL_SEQUENCE_BYTES) == 0 ) {
-			/* HEAD and TAIL still overlap. Remove the TAIL so it can be replaced. */
-			if (red_rmdir(tail_file_name) == 0){
-				logger_next_name(self, tail_file_name);
-				lerr = logger_set_tail(self, tail_file_name);
-				
-				if( lerr != LOGGER_OK ) {
-					/* Failed to increment TAIL. */
-					unlock_mutex(*self->sync_mutex);
-					*err = lerr;
-					return GET_NULL_FILE;
-				}
-			}else{
-				return GET_NULL_FILE;
-			}
-		}
+	lock_mutex( self->sync_mutex );
+	if( !logger_same_position(&cursor->element, &self->head) ) {
+		/* The HEAD has moved on, the cursor's element is no longer appended to. */
+		unlock_mutex( self->sync_mutex );
+		return LOGGER_INV_CAP;
 	}
-	
-	/* Insert at HEAD. */
-	/* First check if we are inserting an empty file. */
-	if( file_to_insert_name == NULL ) {
-		/* Inserting an empty file, lets create it. */
-		head_file_handle = red_open(head_file_name, RED_O_RDWR);
-		if(RED_FILE_ERR == head_file_handle){return GET_NULL_FILE;}
-		
-	} else {
-		/* Inserting the file given as a function argument. Lets process that string to avoid some errors. */
-		strncpy(new_head_file_name, file_to_insert_name, FILESYSTEM_MAX_NAME_LENGTH);
-		new_head_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
-		/* Now rename it so that the ring buffer can track it. */
-		/* Due to corruption, a file by this name may exist already, remove it if one does. */
-		//origin: head_file_name, which is strange: why delete it and rename it again?
-		if( (head_file_handle = red_open(head_file_name, RED_O_RDWR) )!= RED_FILE_ERR ) {
-			/*close the file before removal*/
-			red_close(head_file_handle);
-			red_rmdir(head_file_name);
-		}
-		fs_err = red_rename(new_head_file_name, head_file_name);
-		if( fs_err != 0 ) {
-			/* Failed to rename it, all we can do is abort. */
-			unlock_mutex(*self->sync_mutex);
-			*err = LOGGER_NVMEM_ERR;
-			return GET_NULL_FILE;
-		}
-		/* Finally, lets open it. */
-		head_file_handle = red_open(head_file_name, RED_O_RDWR);
+	if( self->head_handle == RED_FILE_ERR ) {
+		lerr = logger_open_head(self, MUTEX_FALSE);
 	}
-
-	/* Check we opened the file without errors. */
-	if( RED_FILE_ERR == head_file_handle ) {
-		/* Failed to open the file, all we can do is abort. */
-		unlock_mutex(*self->sync_mutex);
-		*err = LOGGER_NVMEM_ERR;
-		return GET_NULL_FILE;
+	if( lerr == LOGGER_OK ) {
+		lerr = logger_flush_locked(self);
 	}
-	/* The file is open and named such that it can be the HEAD, so, lets make it so. */
-	lerr = logger_set_head(self, head_file_name);
-	if( lerr != LOGGER_OK ) {
-		/* Failed to set HEAD. */
-		red_close(head_file_handle);
-		unlock_mutex(*self->sync_mutex);
-		*err = lerr;
-		return GET_NULL_FILE;
+	on_file = self->head_size;
+	if( lerr == LOGGER_OK && offset > on_file ) {
+		lerr = LOGGER_INV_CAP;
 	}
-	/* Insert successful.. */
-	unlock_mutex( *self->sync_mutex );
-	red_close(head_file_handle);
-	*err = LOGGER_OK;
-	return head_file_handle;
+	if( lerr == LOGGER_OK && offset < on_file ) {
+		if( red_ftruncate(self->head_handle, (uint64_t) offset) == RED_FILE_ERR ||
+			red_lseek(self->head_handle, (int64_t) offset, RED_SEEK_SET) == RED_FILE_ERR ) {
+			/* Reopening seeks to the real end of the file. */
+			red_close(self->head_handle);
+			self->head_handle = RED_FILE_ERR;
+			self->head_size = 0;
+			if( self->byte_quota != 0 ) {
+				self->occupancy_valid = MUTEX_FALSE;
+			}
+			lerr = LOGGER_NVMEM_ERR;
+		} else {
+			logger_forget_element(self, self->head.sequence, (uint64_t) (on_file - offset));
+			self->head_size = offset;
+			self->head_crc = LOGGER_CRC32_INIT;
+			self->head_crc_valid = (offset == 0) ? MUTEX_TURE : MUTEX_FALSE;
+		}
+	}
+	if( lerr == LOGGER_OK ) {
+		cursor->offset = offset;
+	}
+	unlock_mutex( self->sync_mutex );
+	return lerr;
 }
 
-/**/
-int32_t logger_peek_tail( logger_t* self, logger_error_t* err )
+logger_error_t logger_cursor_close( logger_cursor_t* cursor )
 {
-	DEV_ASSERT( self );
-	DEV_ASSERT( err );
+	DEV_ASSERT( cursor );
 
-	int32_t 	tail_file_handle;
-	char const* tail_file_name;
+	return logger_flush(cursor->logger);
+}
+
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Move <b>cursor</b> to the first element at or after it that is still in the ring buffer.
+ * @details
+ * 		A cursor behind the TAIL, or left over from an earlier lap of the ring, starts again at the TAIL.
+ * 		Must hold the mutex with logger_t::occupancy built.
+ * @param name[out]
+ * 		File name of the element.
+ * @returns
+ * 		False if there is no element yet.
+ */
+static bool_t logger_read_resolve( logger_t* self, logger_read_cursor_t* cursor, char* name )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(cursor);
+	DEV_ASSERT(name);
 
-	lock_mutex( *self->sync_mutex);
+	logger_position_t	expected = cursor->element;
+	uint32_t			behind, slot, gap;
 
-	/* Get name of tail. */
-	tail_file_name = logger_get_tail(self, err);
-	if( *err != LOGGER_OK ) {
-		unlock_mutex(*self->sync_mutex);
-		return GET_NULL_FILE;
+	if( !cursor->started || cursor->element.sequence >= self->max_capacity ) {
+		cursor->element = self->tail;
+		cursor->offset = 0;
+		cursor->started = MUTEX_TURE;
+	}
+	if( logger_is_live(self, &cursor->element) ) {
+		logger_element_name(self, &cursor->element, name);
+		return MUTEX_TURE;
 	}
 
-	/* Open tail file. */
-	tail_file_handle = red_open(tail_file_name, RED_O_RDWR);
-	if( RED_FILE_ERR == tail_file_handle ) {
-		/* Tail needs to be updated. */
-		*err = logger_update_tail(self);
-		if( *err != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			return GET_NULL_FILE;
-		}
+	behind = (uint32_t) logger_distance(self, &cursor->element, &self->head);
+	logger_advance_position(self, &expected, behind);
+	if( behind > logger_distance(self, &self->tail, &self->head) || expected.temporal != self->head.temporal ) {
+		/* Popped or overwritten. */
+		cursor->element = self->tail;
+	}
+	cursor->offset = 0;
 
-		/* Updated tail, try opening the file again. */
-		tail_file_name = logger_get_tail(self, err);
-		if( *err != LOGGER_OK ) {
-			unlock_mutex(*self->sync_mutex);
-			return GET_NULL_FILE;
-		}
-		tail_file_handle = red_open(tail_file_name, RED_O_RDONLY);
+	/* Skip the holes up to the next live slot. */
+	slot = logger_find_slot(self, cursor->element.sequence, self->head.sequence);
+	if( slot == self->max_capacity ) {
+		return MUTEX_FALSE;
 	}
-	/*Check if the tail file is updated successfully*/
-	if( RED_FILE_ERR == tail_file_handle ) {
-		*err = LOGGER_NVMEM_ERR;
-		unlock_mutex(*self->sync_mutex);
-		return GET_NULL_FILE;
+	gap = (slot >= cursor->element.sequence) ? slot - cursor->element.sequence : (uint32_t) self->max_capacity - cursor->element.sequence + slot;
+	logger_advance_position(self, &cursor->element, gap);
+	if( !logger_is_live(self, &cursor->element) ) {
+		return MUTEX_FALSE;
 	}
-	*err = LOGGER_OK;
-	unlock_mutex( *self->sync_mutex );
-	return tail_file_handle;
+	logger_element_name(self, &cursor->element, name);
+	return MUTEX_TURE;
 }
 
-/*pop a filename from log file that alreadly existed in*/
-logger_error_t logger_pop( logger_t* self, char* popped_file_name )
+logger_error_t logger_read_chunk( logger_t* self, logger_read_cursor_t* cursor, void* buffer, size_t size, logger_chunk_t* chunk )
 {
 	DEV_ASSERT( self );
+	DEV_ASSERT( cursor );
+	DEV_ASSERT( buffer );
+	DEV_ASSERT( chunk );
 
-	logger_error_t 	lerr;
-	char*			tail_file_name;
-	char const* 	head_file_name;
-	//uint32_t		fs_err;
-	int32_t			tail_file_handle;
+	char				file_name[FILESYSTEM_MAX_NAME_LENGTH+1];
+	logger_error_t		lerr;
+	bool_t				found, at_head;
+	int32_t				got;
+	size_t				length;
+	uint32_t			tries;
 
-	lock_mutex( *self->sync_mutex);
+	for( tries = 0; tries <= self->max_capacity; ++tries ) {
+		if( cursor->handle == RED_FILE_ERR ) {
+			lock_mutex( self->sync_mutex );
+			lerr = logger_require_occupancy(self);
+			if( lerr != LOGGER_OK ) {
+				unlock_mutex( self->sync_mutex );
+				return lerr;
+			}
+			found = logger_read_resolve(self, cursor, file_name);
+			at_head = logger_same_position(&cursor->element, &self->head);
+			unlock_mutex( self->sync_mutex );
+			if( !found ) {
+				return LOGGER_EMPTY;
+			}
 
-	/* Get the TAIL file. */
-	tail_file_name = logger_get_tail(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		unlock_mutex( *self->sync_mutex );
-		return lerr;
-	}
+			cursor->handle = red_open(file_name, RED_O_RDONLY);
+			if( RED_FILE_ERR == cursor->handle ) {
+				if( at_head ) {
+					return LOGGER_EMPTY;
+				}
+				/* Popped since, and resolved again, or lost outside the logger with its slot still */
+				/* live. Step over a lost element, a hole never ends the read. */
+				lock_mutex( self->sync_mutex );
+				if( logger_require_occupancy(self) == LOGGER_OK && logger_is_live(self, &cursor->element) ) {
+					logger_next_position(self, &cursor->element);
+					cursor->offset = 0;
+				}
+				unlock_mutex( self->sync_mutex );
+				continue;
+			}
+			if( red_lseek(cursor->handle, (int64_t) cursor->offset, RED_SEEK_SET) == RED_FILE_ERR ) {
+				logger_read_cursor_close(cursor);
+				return LOGGER_NVMEM_ERR;
+			}
+			cursor->ahead_position = 0;
+			cursor->ahead_length = 0;
+		}
 
-	/* Check if this file exists, if not, we have to update the TAIL. */
-	tail_file_handle = red_open(tail_file_name, RED_O_RDWR);
-	if( NULL == tail_file_handle ) {
-		/* File doesn't exist, so update TAIL. */
-		lerr = logger_update_tail(self);
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex( *self->sync_mutex );
-			return lerr;
+		/* Top up the read ahead so the chunk can be whole. */
+		if( cursor->ahead_length - cursor->ahead_position < size && cursor->ahead_length - cursor->ahead_position < LOGGER_READ_AHEAD_SIZE ) {
+			memmove(cursor->ahead, cursor->ahead + cursor->ahead_position, cursor->ahead_length - cursor->ahead_position);
+			cursor->ahead_length -= cursor->ahead_position;
+			cursor->ahead_position = 0;
+			got = red_read(cursor->handle, cursor->ahead + cursor->ahead_length, (uint32_t) (LOGGER_READ_AHEAD_SIZE - cursor->ahead_length));
+			if( RED_FILE_ERR == got ) {
+				logger_read_cursor_close(cursor);
+				return LOGGER_NVMEM_ERR;
+			}
+			cursor->ahead_length += (size_t) got;
 		}
-		/* Get name of TAIL. */
-		tail_file_name = logger_get_tail(self, &lerr);
-		if( lerr != LOGGER_OK ) {
-			unlock_mutex( *self->sync_mutex );
-			return lerr;
+
+		if( cursor->ahead_length > cursor->ahead_position ) {
+			length = cursor->ahead_length - cursor->ahead_position;
+			if( length > size ) {
+				length = size;
+			}
+			memcpy(buffer, cursor->ahead + cursor->ahead_position, length);
+			cursor->ahead_position += length;
+
+			chunk->element = cursor->element;
+			chunk->offset = cursor->offset;
+			chunk->length = length;
+			chunk->crc = logger_crc32(LOGGER_CRC32_INIT, buffer, length);
+			cursor->offset += (uint32_t) length;
+			return LOGGER_OK;
 		}
-	} 
-	// else if( fs_err != FS_OK ) {
-	// 	/* Failed to check for file existance. */
-	// 	//unlock_mutex( *self->sync_mutex );
-	// 	return LOGGER_NVMEM_ERR;
-	// }
 
-	/* Check if this is the HEAD file. If it is, don't touch it. */
-	head_file_name = logger_get_head(self, &lerr);
-	if( lerr != LOGGER_OK ) {
-		unlock_mutex( *self->sync_mutex );
-		return lerr;
+		/* End of the element. The HEAD may still grow, anything else is done with. */
+		lock_mutex( self->sync_mutex );
+		at_head = logger_same_position(&cursor->element, &self->head);
+		if( !at_head ) {
+			logger_next_position(self, &cursor->element);
+			cursor->offset = 0;
+		}
+		unlock_mutex( self->sync_mutex );
+		if( at_head ) {
+			return LOGGER_EMPTY;
+		}
+		logger_read_cursor_close(cursor);
 	}
-	if( strncmp(head_file_name, tail_file_name, FILESYSTEM_MAX_NAME_LENGTH) == 0 ) {
-		/* HEAD == TAIL, don't untrack head.. */
-		unlock_mutex( *self->sync_mutex );
-		return LOGGER_EMPTY;
+	return LOGGER_EMPTY;
+}
+
+void logger_read_cursor_close( logger_read_cursor_t* cursor )
+{
+	DEV_ASSERT( cursor );
+
+	if( cursor->handle != RED_FILE_ERR ) {
+		red_close(cursor->handle);
+		cursor->handle = RED_FILE_ERR;
 	}
+	cursor->ahead_position = 0;
+	cursor->ahead_length = 0;
+}
 
-	/* We're removing this file from the ring buffer tracking, so untrack the file. */
-	/* This operation just renames it. */
-	printf("FILE READY FOR BEING POPOED(BEFORE RENAMED): %s\n",tail_file_name);
-	lerr = logger_untrack_file(self, tail_file_name);
-	if( lerr != LOGGER_OK ) {
-		/* Failed to untrack the file. */
-		unlock_mutex( *self->sync_mutex );
-		return lerr;
+void initialize_logger_read_cursor( logger_read_cursor_t *self, logger_position_t const* element, uint32_t offset )
+{
+	DEV_ASSERT( self );
+
+	self->started = (element != NULL) ? MUTEX_TURE : MUTEX_FALSE;
+	if( element != NULL ) {
+		self->element = *element;
 	}
+	self->offset = offset;
+	self->handle = RED_FILE_ERR;
+	self->ahead_position = 0;
+	self->ahead_length = 0;
+}
 
-	/* Got the file that is going to be removed, copy it into input buffer. */
-	 if( popped_file_name != NULL ) {
+logger_error_t logger_submit_insert( logger_t* self, char const* file_name, logger_callback_t done, void* arg )
+{
+	DEV_ASSERT( self );
 
-		/* Copy name of popped file into here. */
-		strncpy(popped_file_name, tail_file_name, FILESYSTEM_MAX_NAME_LENGTH);
-		popped_file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
-	} 
+	logger_request_t request;
 
-	/* Update the TAIL. */
-	lerr = logger_update_tail(self);
-	
-	unlock_mutex( *self->sync_mutex );
-	return lerr;
+	request.logger = self;
+	request.op = LOGGER_REQUEST_INSERT;
+	if( file_name != NULL ) {
+		strncpy(request.file_name, file_name, FILESYSTEM_MAX_NAME_LENGTH);
+		request.file_name[FILESYSTEM_MAX_NAME_LENGTH] = '\0';
+	} else {
+		request.file_name[0] = '\0';
+	}
+	request.buffer = NULL;
+	request.length = 0;
+	request.done = done;
+	request.arg = arg;
+	return logger_submit(&request);
 }
 
-void logger_task(){
-
-    logger_t self;
-    logger_error_t lerr,err;
-    int32_t rederr;
-    bool_t logger_is_init = MUTEX_FALSE;
+logger_error_t logger_submit_append( logger_t* self, void const* buffer, size_t length, logger_callback_t done, void* arg )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( buffer || length == 0 );
 
-    char control_file_name[] = "a.log";
-    char element_file_name = 100;
-    size_t max_capacity = 100;
+	logger_request_t request;
 
-    char popped_file_name[13] = "00110001.log";
-    popped_file_name[12] = "\0";
+	request.logger = self;
+	request.op = LOGGER_REQUEST_APPEND;
+	request.file_name[0] = '\0';
+	request.buffer = buffer;
+	request.length = length;
+	request.done = done;
+	request.arg = arg;
+	return logger_submit(&request);
+}
 
-    char file_to_insert_name[13] = "00020001.log";
-    file_to_insert_name[12] = "\0";
+/**
+ * @memberof logger_t @private
+ * @brief
+ * 		Carry out a run of requests that all target the same logger.
+ * @details
+ * 		The logger's mutex is taken once. Consecutive inserts become one logger_insert_batch( ), so
+ * 		they share one control file update, and staged appends are flushed and committed once at the
+ * 		end, before any waiter is told they are durable. Empty appends touch nothing. Sweeps
+ * 		queued by popping are done in batches of LOGGER_SWEEP_BATCH, and claimed pool files are
+ * 		replaced.
+ * 		The results are written to <b>errors</b>, one per request.
+ */
+static void logger_commit_group( logger_request_t const* requests, size_t count, logger_error_t* errors )
+{
+	logger_t*		self = requests[0].logger;
+	char const*		names[LOGGER_WRITER_GROUP_SIZE];
+	size_t			first_insert = 0;
+	size_t			inserts = 0;
+	size_t			inserted;
+	size_t			i, j;
+	logger_error_t	lerr;
+	bool_t			appended = MUTEX_FALSE;
 
-    const char contrl_file_path[] = "a.log";//VOL0:/
-    const char popped_file_path[] = "00010000.log";
-    const char insert_file_path[] = "00020001.log";
+	lock_mutex(self->sync_mutex);
+	for( i = 0; i <= count; ++i ) {
+		if( i < count && requests[i].op == LOGGER_REQUEST_INSERT ) {
+			if( inserts == 0 ) {
+				first_insert = i;
+			}
+			names[inserts++] = (requests[i].file_name[0] != '\0') ? requests[i].file_name : NULL;
+			continue;
+		}
 
-    rederr  = red_open(contrl_file_path, RED_O_RDWR);
-    if (rederr == -1) {
-        rederr = red_open(contrl_file_path, RED_O_CREAT | RED_O_RDWR);
-        if (rederr == -1) {
-            exit(red_errno);
-        }
-        else{
-            red_close(rederr);
-        }
-    }
-    rederr  = red_open(popped_file_path, RED_O_RDWR);
-    if (rederr == -1) {
-        rederr = red_open(popped_file_path, RED_O_CREAT | RED_O_RDWR);
-        if (rederr == -1) {
-            exit(red_errno);
-        }
-        else{
-            red_close(rederr);
-       }
-    }
-    rederr  = red_open(insert_file_path, RED_O_RDWR);
-    if (rederr == -1) {
-        rederr = red_open(insert_file_path, RED_O_CREAT | RED_O_RDWR);
-        if (rederr == -1) {
-            exit(red_errno);
-        }
-        else{
-            red_close(rederr);
-        }
-    }
+		/* End of a run of inserts, keep them in order with the appends around them. */
+		if( inserts > 0 ) {
+			lerr = logger_insert_batch_locked(self, names, inserts, &inserted);
+			for( j = 0; j < inserts; ++j ) {
+				errors[first_insert + j] = (j < inserted) ? LOGGER_OK : ((lerr != LOGGER_OK) ? lerr : LOGGER_NVMEM_ERR);
+			}
+			inserts = 0;
+		}
+		if( i < count && requests[i].op == LOGGER_REQUEST_SWEEP ) {
+			/* Queued by popping, keep going in batches while enough is waiting. */
+			self->sweep_queued = MUTEX_FALSE;
+			errors[i] = logger_sweep_locked(self, LOGGER_SWEEP_BATCH, NULL);
+			if( errors[i] == LOGGER_OK && logger_distance(self, &self->retired, &self->tail) >= LOGGER_SWEEP_BATCH ) {
+				logger_submit_upkeep(self, LOGGER_REQUEST_SWEEP, &self->sweep_queued);
+			}
+		} else if( i < count && requests[i].op == LOGGER_REQUEST_REFILL ) {
+			self->pool_queued = MUTEX_FALSE;
+			errors[i] = logger_fill_pool_locked(self);
+		} else if( i < count && requests[i].length == 0 ) {
+			/* Nothing to write, must not open or rotate the HEAD. */
+			errors[i] = LOGGER_OK;
+		} else if( i < count ) {
+			errors[i] = logger_append_locked(self, requests[i].buffer, requests[i].length);
+			appended = MUTEX_TURE;
+		}
+	}
 
-    //test demo start here, modify it as wish
-    if(initialize_logger(&self, control_file_name, element_file_name, max_capacity, logger_is_init) == LOGGER_OK){
-        ex2_log("INITIALIZED OK!\n");
-        ex2_log("INIT HEAD NAME: %s\nINIT TAIL NAME: %s\n\n", self.head_file_name, self.tail_file_name);
-    }
-    else{
-        ex2_log("LOGGER FAILED, ERROR CODE: %d\n", (int)lerr);
-    }
+	/* Appends only complete once they are on flash and committed. A transaction point */
+	/* covers the whole volume, so it also commits elements sealed by rotation above. */
+	lerr = logger_flush_locked(self);
+	if( lerr == LOGGER_OK && appended ) {
+		if( self->head_handle != RED_FILE_ERR ) {
+			lerr = (red_fsync(self->head_handle) == RED_FILE_ERR) ? LOGGER_NVMEM_ERR : LOGGER_OK;
+		} else {
+			lerr = (red_transact(LOGGER_ELEMENT_DIRECTORY) == RED_FILE_ERR) ? LOGGER_NVMEM_ERR : LOGGER_OK;
+		}
+	}
+	unlock_mutex(self->sync_mutex);
+	logger_share_quota(self);
+	if( lerr != LOGGER_OK ) {
+		for( i = 0; i < count; ++i ) {
+			if( requests[i].op == LOGGER_REQUEST_APPEND && errors[i] == LOGGER_OK ) {
+				errors[i] = lerr;
+			}
+		}
+	}
+}
 
-   if(logger_insert(&self, &err, file_to_insert_name) == NULL)
-       ex2_log("NULL FILE\n");
-    else
-    {
-        ex2_log("INSERTED OK!\n");
-        ex2_log("CURRENT HEAD NAME: %s\nCURRENT TAIL NAME: %s\n\n", self.head_file_name, self.tail_file_name);
-    }
+/* Writer task. Takes insert / append requests off the queue and commits them in groups. */
+void logger_task(){
 
-    if(logger_pop(&self, popped_file_name) != LOGGER_OK){
-        ex2_log("POP FAILED\n");
-    }
-    else
-    {
-        ex2_log("POPPED FILE NAME: %s\n", popped_file_name);
-        ex2_log("CURRENT HEAD NAME: %s\nCURRENT TAIL NAME: %s\n\n", self.head_file_name, self.tail_file_name);
-    }
+	logger_request_t	group[LOGGER_WRITER_GROUP_SIZE];
+	logger_error_t		errors[LOGGER_WRITER_GROUP_SIZE];
+	size_t				count;
+	size_t				first, last;
+	size_t				i;
 
-    logger_peek_tail(&self, &err);
-    if(err != LOGGER_OK)
-        ex2_log("PEEK TAIL FAILED\n");
-    else
-    {
-        ex2_log("PEEK TAIL OK!\n");
-        ex2_log("CURRENT HEAD NAME: %s\nCURRENT TAIL NAME: %s\n\n", self.head_file_name, self.tail_file_name);
-    }
+	for( ;; ) {
+		/* Wait for work, then take whatever else is already queued. */
+		if( xQueueReceive(logger_writer_queue, &group[0], portMAX_DELAY) != pdTRUE ) {
+			continue;
+		}
+		count = 1;
+		while( count < LOGGER_WRITER_GROUP_SIZE && xQueueReceive(logger_writer_queue, &group[count], 0) == pdTRUE ) {
+			++count;
+		}
 
-    logger_peek_head(&self, &err);
-    if(err != LOGGER_OK)
-        ex2_log("PEEK HEAD FAILED\n");
-    else
-    {
-        ex2_log("PEEK HEAD OK!\n");
-        ex2_log("CURRENT HEAD NAME: %s\nCURRENT TAIL NAME: %s\n\n", self.head_file_name, self.tail_file_name);
-    }
+		/* Commit each run of requests for the same logger together. */
+		for( first = 0; first < count; first = last ) {
+			for( last = first + 1; last < count && group[last].logger == group[first].logger; ++last );
+			logger_commit_group(&group[first], last - first, &errors[first]);
+		}
 
+		for( i = 0; i < count; ++i ) {
+			if( group[i].done != NULL ) {
+				group[i].done(group[i].logger, errors[i], group[i].arg);
+			}
+		}
+	}
 }
 
 SAT_returnState start_logger_task(void) {
+    if( logger_writer_queue == NULL ) {
+        logger_writer_queue = xQueueCreate(LOGGER_WRITER_QUEUE_LENGTH, sizeof(logger_request_t));
+        if( logger_writer_queue == NULL ) {
+            ex2_log("FAILED TO CREATE logger queue\n");
+            return SATR_ERROR;
+        }
+    }
     if (xTaskCreate((TaskFunction_t)logger_task,
                   "logger system", 2048, NULL, LOGGER_TASK_PRIO,
                   NULL) != pdPASS) {
@@ -0,0 +1,344 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_codec.c
+ * @date October 16, 2026
+ * @brief
+ * 		Block compression of data appended to a logger_t.
+ */
+
+#include <string.h>
+#include <logger_codec.h>
+#include <logger_endian.h>
+
+/* Match distances are 12 bits, lengths are 16 bits in the block header. */
+#if LOGGER_CODEC_BLOCK_SIZE > 4096
+#error "LOGGER_CODEC_BLOCK_SIZE must be 4096 or less"
+#endif
+
+#define LOGGER_LZSS_MIN_MATCH 3
+#define LOGGER_LZSS_MAX_MATCH (LOGGER_LZSS_MIN_MATCH+15)
+#define LOGGER_LZSS_NONE 0xFFFF
+
+/********************************************************************************/
+/* LZSS Codec																	*/
+/********************************************************************************/
+static inline uint32_t logger_lzss_hash( uint8_t const* at )
+{
+	return ((uint32_t) at[0] * 33 + (uint32_t) at[1] * 7 + at[2]) & (LOGGER_LZSS_HASH_SIZE - 1);
+}
+
+/**
+ * @memberof logger_lzss_t @private
+ * @brief
+ * 		logger_codec_t::compress for LZSS.
+ */
+static size_t logger_lzss_compress( logger_codec_t* codec, uint8_t const* in, size_t length, uint8_t* out, size_t size )
+{
+	DEV_ASSERT(codec);
+
+	logger_lzss_t*	self = (logger_lzss_t*) codec;
+	size_t			i = 0, o = 0, flags = 0;
+	size_t			best_length, match, limit, p;
+	uint32_t		best_distance = 0;
+	uint16_t		candidate;
+	unsigned int	bit = 8, depth;
+
+	for( p = 0; p < LOGGER_LZSS_HASH_SIZE; ++p ) {
+		self->head[p] = LOGGER_LZSS_NONE;
+	}
+
+	while( i < length ) {
+		if( bit == 8 ) {
+			/* Next eight tokens' flags. */
+			if( o >= size ) {
+				return 0;
+			}
+			flags = o++;
+			out[flags] = 0;
+			bit = 0;
+		}
+
+		/* Longest match among the most recent positions with the same hash. */
+		best_length = 0;
+		limit = length - i;
+		if( limit > LOGGER_LZSS_MAX_MATCH ) {
+			limit = LOGGER_LZSS_MAX_MATCH;
+		}
+		if( limit >= LOGGER_LZSS_MIN_MATCH ) {
+			candidate = self->head[logger_lzss_hash(in + i)];
+			for( depth = 0; candidate != LOGGER_LZSS_NONE && depth < LOGGER_LZSS_CHAIN; ++depth ) {
+				for( match = 0; match < limit && in[candidate + match] == in[i + match]; ++match );
+				if( match > best_length ) {
+					best_length = match;
+					best_distance = (uint32_t) (i - candidate);
+					if( match == limit ) {
+						break;
+					}
+				}
+				candidate = self->prev[candidate];
+			}
+		}
+
+		if( best_length >= LOGGER_LZSS_MIN_MATCH ) {
+			if( o + 2 > size ) {
+				return 0;
+			}
+			out[o++] = (uint8_t) (best_distance - 1);
+			out[o++] = (uint8_t) ((((best_distance - 1) >> 8) << 4) | (best_length - LOGGER_LZSS_MIN_MATCH));
+		} else {
+			if( o >= size ) {
+				return 0;
+			}
+			out[flags] |= (uint8_t) (1 << bit);
+			out[o++] = in[i];
+			best_length = 1;
+		}
+		++bit;
+
+		/* Every position covered goes into the chains. */
+		for( p = i + best_length; i < p; ++i ) {
+			if( length - i >= LOGGER_LZSS_MIN_MATCH ) {
+				self->prev[i] = self->head[logger_lzss_hash(in + i)];
+				self->head[logger_lzss_hash(in + i)] = (uint16_t) i;
+			}
+		}
+	}
+	return o;
+}
+
+/**
+ * @memberof logger_lzss_t @private
+ * @brief
+ * 		logger_codec_t::expand for LZSS.
+ */
+static size_t logger_lzss_expand( logger_codec_t* codec, uint8_t const* in, size_t length, uint8_t* out, size_t size )
+{
+	DEV_ASSERT(codec);
+
+	size_t			i = 0, o = 0, distance, match;
+	uint8_t			flags;
+	unsigned int	bit;
+
+	(void) codec;
+
+	while( i < length ) {
+		flags = in[i++];
+		for( bit = 0; bit < 8 && i < length; ++bit ) {
+			if( flags & (1 << bit) ) {
+				if( o >= size ) {
+					return 0;
+				}
+				out[o++] = in[i++];
+				continue;
+			}
+			if( i + 2 > length ) {
+				return 0;
+			}
+			distance = ((size_t) in[i] | ((size_t) (in[i+1] >> 4) << 8)) + 1;
+			match = (size_t) (in[i+1] & 0x0F) + LOGGER_LZSS_MIN_MATCH;
+			i += 2;
+			if( distance > o || o + match > size ) {
+				return 0;
+			}
+			/* Byte at a time, a match may overlap what it copies. */
+			for( ; match > 0; --match, ++o ) {
+				out[o] = out[o - distance];
+			}
+		}
+	}
+	return o;
+}
+
+
+/********************************************************************************/
+/* Private Method Definitions													*/
+/********************************************************************************/
+/**
+ * @memberof logger_compressor_t @private
+ * @brief
+ * 		Compress the gathered block and append it.
+ */
+static logger_error_t logger_compressor_emit( logger_compressor_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t	lerr;
+	size_t			packed = 0;
+	uint8_t			id = LOGGER_CODEC_STORED;
+
+	if( self->fill == 0 ) {
+		return LOGGER_OK;
+	}
+
+	if( self->codec != NULL ) {
+		/* Only worth keeping if it is smaller. */
+		packed = self->codec->compress(self->codec, self->raw, self->fill, self->frame + LOGGER_CODEC_HEADER_LENGTH, self->fill - 1);
+		id = self->codec->id;
+	}
+	if( packed == 0 ) {
+		memcpy(self->frame + LOGGER_CODEC_HEADER_LENGTH, self->raw, self->fill);
+		packed = self->fill;
+		id = LOGGER_CODEC_STORED;
+		++self->stored_blocks;
+	}
+
+	self->frame[0] = id;
+	logger_put_u16(self->frame + 1, (uint16_t) self->fill);
+	logger_put_u16(self->frame + 3, (uint16_t) packed);
+	lerr = logger_append(self->logger, self->frame, LOGGER_CODEC_HEADER_LENGTH + packed);
+
+	/* The block is dropped if it fails. logger_append( ) can fail after taking the record, when */
+	/* keeping to the quota, so appending it again could store it twice. */
+	if( lerr != LOGGER_OK ) {
+		++self->dropped_blocks;
+	} else {
+		self->raw_bytes += self->fill;
+		self->packed_bytes += LOGGER_CODEC_HEADER_LENGTH + packed;
+		++self->blocks;
+	}
+	self->fill = 0;
+	return lerr;
+}
+
+
+/********************************************************************************/
+/* Public Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_compressor_write( logger_compressor_t* self, void const* data, size_t length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( data || length == 0 );
+
+	uint8_t const*	bytes = (uint8_t const*) data;
+	size_t			room;
+	logger_error_t	lerr = LOGGER_OK, emit_err;
+
+	while( length > 0 ) {
+		room = LOGGER_CODEC_BLOCK_SIZE - self->fill;
+		if( room > length ) {
+			room = length;
+		}
+		memcpy(self->raw + self->fill, bytes, room);
+		self->fill += room;
+		bytes += room;
+		length -= room;
+		if( self->fill == LOGGER_CODEC_BLOCK_SIZE ) {
+			/* Carry on past a dropped block, so all of data is taken whatever is returned. */
+			emit_err = logger_compressor_emit(self);
+			if( lerr == LOGGER_OK ) {
+				lerr = emit_err;
+			}
+		}
+	}
+	return lerr;
+}
+
+logger_error_t logger_compressor_flush( logger_compressor_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
+
+	lerr = logger_compressor_emit(self);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	return logger_flush(self->logger);
+}
+
+logger_error_t logger_decompressor_read( logger_decompressor_t* self, void* buffer, size_t size, size_t* length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( buffer );
+	DEV_ASSERT( length );
+
+	uint8_t		header[LOGGER_CODEC_HEADER_LENGTH];
+	size_t		raw, packed;
+	int32_t		got;
+
+	*length = 0;
+	got = red_read(self->handle, header, sizeof(header));
+	if( got == 0 ) {
+		return LOGGER_EMPTY;
+	}
+	if( got != (int32_t) sizeof(header) ) {
+		return (RED_FILE_ERR == got) ? LOGGER_NVMEM_ERR : LOGGER_EMPTY;
+	}
+	raw = logger_get_u16(header + 1);
+	packed = logger_get_u16(header + 3);
+	if( raw > LOGGER_CODEC_BLOCK_SIZE || packed > LOGGER_CODEC_BLOCK_SIZE ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	if( raw > size ) {
+		return LOGGER_INV_CAP;
+	}
+
+	if( header[0] == LOGGER_CODEC_STORED ) {
+		if( packed != raw || red_read(self->handle, buffer, (uint32_t) raw) != (int32_t) raw ) {
+			return LOGGER_NVMEM_ERR;
+		}
+		*length = raw;
+		return LOGGER_OK;
+	}
+
+	if( self->codec == NULL || header[0] != self->codec->id ) {
+		return LOGGER_INV_CAP;
+	}
+	if( red_read(self->handle, self->packed, (uint32_t) packed) != (int32_t) packed ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	if( self->codec->expand(self->codec, self->packed, packed, (uint8_t*) buffer, raw) != raw ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	*length = raw;
+	return LOGGER_OK;
+}
+
+
+/********************************************************************************/
+/* Initialization Method Definitions											*/
+/********************************************************************************/
+logger_codec_t* initialize_logger_lzss( logger_lzss_t *self )
+{
+	DEV_ASSERT( self );
+
+	self->codec.id = LOGGER_CODEC_LZSS;
+	self->codec.compress = logger_lzss_compress;
+	self->codec.expand = logger_lzss_expand;
+	return &self->codec;
+}
+
+logger_error_t initialize_logger_compressor( logger_compressor_t *self, logger_t* logger, logger_codec_t* codec )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( logger );
+
+	self->logger = logger;
+	self->codec = codec;
+	self->fill = 0;
+	self->raw_bytes = 0;
+	self->packed_bytes = 0;
+	self->blocks = 0;
+	self->stored_blocks = 0;
+	self->dropped_blocks = 0;
+	return LOGGER_OK;
+}
+
+logger_error_t initialize_logger_decompressor( logger_decompressor_t *self, int32_t handle, logger_codec_t* codec )
+{
+	DEV_ASSERT( self );
+
+	self->handle = handle;
+	self->codec = codec;
+	return LOGGER_OK;
+}
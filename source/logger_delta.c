@@ -0,0 +1,263 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_delta.c
+ * @date October 16, 2026
+ * @brief
+ * 		Delta and varint encoding of fixed layout samples into segment elements.
+ */
+
+#include <string.h>
+#include <logger_delta.h>
+
+#if LOGGER_DELTA_BLOCK_HEADER + LOGGER_DELTA_SAMPLE_MAX > LOGGER_SEGMENT_MAX_RECORD
+#error "LOGGER_SEGMENT_MAX_RECORD is too small for a sample of LOGGER_DELTA_MAX_CHANNELS channels"
+#endif
+
+/********************************************************************************/
+/* Varints																		*/
+/********************************************************************************/
+/* Small magnitudes of either sign to small numbers: 0, -1, 1, -2 ... to 0, 1, 2, 3 ... */
+static inline uint32_t logger_delta_zigzag( uint32_t value )
+{
+	return (value << 1) ^ (uint32_t) -(int32_t) (value >> 31);
+}
+
+static inline uint32_t logger_delta_unzigzag( uint32_t value )
+{
+	return (value >> 1) ^ (uint32_t) -(int32_t) (value & 1);
+}
+
+static inline size_t logger_delta_put_varint( uint8_t* at, uint32_t value )
+{
+	size_t length = 0;
+
+	while( value >= 0x80 ) {
+		at[length++] = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	at[length++] = (uint8_t) value;
+	return length;
+}
+
+/**
+ * @memberof logger_delta_reader_t @private
+ * @brief
+ * 		Decode a varint from the block, false if it runs past the end.
+ */
+static bool_t logger_delta_get_varint( logger_delta_reader_t* self, uint32_t* value )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(value);
+
+	uint32_t		shift;
+	uint8_t			byte;
+
+	*value = 0;
+	for( shift = 0; shift < 7 * LOGGER_DELTA_VARINT_MAX; shift += 7 ) {
+		if( self->position >= self->length ) {
+			return MUTEX_FALSE;
+		}
+		byte = self->block[self->position++];
+		*value |= (uint32_t) (byte & 0x7F) << shift;
+		if( (byte & 0x80) == 0 ) {
+			return MUTEX_TURE;
+		}
+	}
+	return MUTEX_FALSE;
+}
+
+
+/********************************************************************************/
+/* Writer Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_delta_write( logger_delta_t* self, uint32_t timestamp, int32_t const* values )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( values );
+
+	logger_error_t	lerr;
+	uint8_t			channel;
+
+	if( timestamp < self->timestamp ) {
+		return LOGGER_INV_CAP;
+	}
+
+	if( self->count == self->interval ||
+		(self->count > 0 && self->length + LOGGER_DELTA_SAMPLE_MAX > sizeof(self->block)) ) {
+		lerr = logger_delta_flush(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+
+	if( self->count == 0 ) {
+		/* Keyframe, its time is the record's time stamp. */
+		self->length = LOGGER_DELTA_BLOCK_HEADER;
+		self->first = timestamp;
+		for( channel = 0; channel < self->channels; ++channel ) {
+			self->length += logger_delta_put_varint(self->block + self->length, logger_delta_zigzag((uint32_t) values[channel]));
+		}
+	} else {
+		self->length += logger_delta_put_varint(self->block + self->length, timestamp - self->timestamp);
+		for( channel = 0; channel < self->channels; ++channel ) {
+			self->length += logger_delta_put_varint(self->block + self->length,
+													logger_delta_zigzag((uint32_t) values[channel] - (uint32_t) self->last[channel]));
+		}
+	}
+
+	memcpy(self->last, values, self->channels * sizeof(int32_t));
+	self->timestamp = timestamp;
+	++self->count;
+	self->raw_bytes += sizeof(uint32_t) * (self->channels + 1);
+	return LOGGER_OK;
+}
+
+logger_error_t logger_delta_flush( logger_delta_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t lerr;
+
+	if( self->count == 0 ) {
+		return LOGGER_OK;
+	}
+	self->block[0] = self->count;
+	lerr = logger_segment_write(self->segment, self->first, self->block, self->length);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	self->packed_bytes += self->length;
+	self->count = 0;
+	return LOGGER_OK;
+}
+
+
+/********************************************************************************/
+/* Reader Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_delta_reader_seek( logger_delta_reader_t* self, uint32_t timestamp )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t	lerr;
+	uint32_t		k;
+
+	/* The block before the first that starts after timestamp. When they all start at or before */
+	/* it, k is the number of blocks and this is the last. */
+	if( timestamp < UINT32_MAX ) {
+		lerr = logger_segment_find(self->segment, timestamp + 1, &k);
+		if( lerr != LOGGER_OK && lerr != LOGGER_EMPTY ) {
+			return lerr;
+		}
+	} else {
+		k = logger_segment_count(self->segment);
+	}
+	k = (k > 0) ? k - 1 : 0;
+
+	self->remaining = 0;
+	return logger_segment_seek(self->segment, k);
+}
+
+logger_error_t logger_delta_reader_read( logger_delta_reader_t* self, uint32_t* timestamp, int32_t* values )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( timestamp );
+	DEV_ASSERT( values );
+
+	logger_error_t	lerr;
+	uint32_t		value;
+	uint8_t			channel;
+
+	if( self->remaining == 0 ) {
+		lerr = logger_segment_read(self->segment, self->block, sizeof(self->block), &self->length, &self->timestamp);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+		if( self->length < LOGGER_DELTA_BLOCK_HEADER || self->block[0] == 0 ) {
+			return LOGGER_NVMEM_ERR;
+		}
+		self->remaining = self->block[0];
+		self->position = LOGGER_DELTA_BLOCK_HEADER;
+		self->keyframe = MUTEX_TURE;
+	}
+
+	if( self->keyframe ) {
+		for( channel = 0; channel < self->channels; ++channel ) {
+			if( !logger_delta_get_varint(self, &value) ) {
+				return LOGGER_NVMEM_ERR;
+			}
+			self->last[channel] = (int32_t) logger_delta_unzigzag(value);
+		}
+		self->keyframe = MUTEX_FALSE;
+	} else {
+		if( !logger_delta_get_varint(self, &value) ) {
+			return LOGGER_NVMEM_ERR;
+		}
+		self->timestamp += value;
+		for( channel = 0; channel < self->channels; ++channel ) {
+			if( !logger_delta_get_varint(self, &value) ) {
+				return LOGGER_NVMEM_ERR;
+			}
+			self->last[channel] = (int32_t) ((uint32_t) self->last[channel] + logger_delta_unzigzag(value));
+		}
+	}
+
+	--self->remaining;
+	*timestamp = self->timestamp;
+	memcpy(values, self->last, self->channels * sizeof(int32_t));
+	return LOGGER_OK;
+}
+
+
+/********************************************************************************/
+/* Initialization Method Definitions											*/
+/********************************************************************************/
+logger_error_t initialize_logger_delta( logger_delta_t *self, logger_segment_t* segment, uint8_t channels, uint8_t interval )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( segment );
+
+	if( channels == 0 || channels > LOGGER_DELTA_MAX_CHANNELS || interval == 0 ) {
+		return LOGGER_INV_CAP;
+	}
+
+	self->segment = segment;
+	self->channels = channels;
+	self->interval = interval;
+	self->count = 0;
+	self->first = 0;
+	self->timestamp = 0;
+	self->length = 0;
+	self->raw_bytes = 0;
+	self->packed_bytes = 0;
+	return LOGGER_OK;
+}
+
+logger_error_t initialize_logger_delta_reader( logger_delta_reader_t *self, logger_segment_reader_t* segment, uint8_t channels )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( segment );
+
+	if( channels == 0 || channels > LOGGER_DELTA_MAX_CHANNELS ) {
+		return LOGGER_INV_CAP;
+	}
+
+	self->segment = segment;
+	self->channels = channels;
+	self->remaining = 0;
+	self->keyframe = MUTEX_FALSE;
+	self->timestamp = 0;
+	self->length = 0;
+	self->position = 0;
+	return LOGGER_OK;
+}
@@ -0,0 +1,181 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_fifo.c
+ * @date October 16, 2026
+ * @brief
+ * 		Lock free ring that queues records from an ISR for a logger_t.
+ */
+
+#include <string.h>
+#include <logger_fifo.h>
+
+/********************************************************************************/
+/* Private Method Definitions													*/
+/********************************************************************************/
+/* Copy into the ring at free running index <b>at</b>, wrapping as needed. */
+static inline void logger_fifo_write( logger_fifo_t* self, uint32_t at, void const* data, uint32_t length )
+{
+	uint32_t start = at & self->mask;
+	uint32_t first = (self->mask + 1) - start;
+
+	if( first > length ) {
+		first = length;
+	}
+	memcpy(self->buffer + start, data, first);
+	memcpy(self->buffer, (uint8_t const*) data + first, length - first);
+}
+
+/* Copy out of the ring at free running index <b>at</b>, wrapping as needed. */
+static inline void logger_fifo_read( logger_fifo_t* self, uint32_t at, void* data, uint32_t length )
+{
+	uint32_t start = at & self->mask;
+	uint32_t first = (self->mask + 1) - start;
+
+	if( first > length ) {
+		first = length;
+	}
+	memcpy(data, self->buffer + start, first);
+	memcpy((uint8_t*) data + first, self->buffer, length - first);
+}
+
+/* Length of the record at the TAIL, the ring must not be empty. */
+static inline uint16_t logger_fifo_record_length( logger_fifo_t* self, uint32_t tail )
+{
+	uint8_t header[LOGGER_FIFO_HEADER_BYTES];
+
+	logger_fifo_read(self, tail, header, LOGGER_FIFO_HEADER_BYTES);
+	return (uint16_t) (header[0] | (header[1] << 8));
+}
+
+
+/********************************************************************************/
+/* Public Method Definitions													*/
+/********************************************************************************/
+bool_t logger_fifo_push( logger_fifo_t* self, void const* record, uint16_t length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( record || length == 0 );
+
+	uint8_t		header[LOGGER_FIFO_HEADER_BYTES];
+	uint32_t	head = self->head;
+	uint32_t	frame = (uint32_t) length + LOGGER_FIFO_HEADER_BYTES;
+
+	/* An empty record couldn't be told apart from an empty ring by logger_fifo_pop( ). */
+	if( length == 0 ) {
+		return MUTEX_FALSE;
+	}
+
+	/* Only records logger_fifo_drain( ) can deliver go in the ring. Unsigned arithmetic on the */
+	/* free running indices handles wrap around. */
+	if( length > LOGGER_FIFO_MAX_RECORD || (self->mask + 1) - (head - self->tail) < frame ) {
+		++self->overruns;
+		return MUTEX_FALSE;
+	}
+
+	header[0] = (uint8_t) (length & 0xFF);
+	header[1] = (uint8_t) (length >> 8);
+	logger_fifo_write(self, head, header, LOGGER_FIFO_HEADER_BYTES);
+	logger_fifo_write(self, head + LOGGER_FIFO_HEADER_BYTES, record, length);
+
+	/* The record must be in the ring before the consumer can see it. */
+	LOGGER_MEMORY_BARRIER();
+	self->head = head + frame;
+	return MUTEX_TURE;
+}
+
+size_t logger_fifo_pop( logger_fifo_t* self, void* record, size_t max_length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( record || max_length == 0 );
+
+	uint32_t	tail = self->tail;
+	uint16_t	length;
+
+	if( self->head == tail ) {
+		return 0;
+	}
+	/* Don't read the record before seeing the producer's index. */
+	LOGGER_MEMORY_BARRIER();
+
+	length = logger_fifo_record_length(self, tail);
+	if( length <= max_length ) {
+		logger_fifo_read(self, tail + LOGGER_FIFO_HEADER_BYTES, record, length);
+	}
+
+	/* Done reading before the producer can reuse the space. */
+	LOGGER_MEMORY_BARRIER();
+	self->tail = tail + LOGGER_FIFO_HEADER_BYTES + length;
+	return (length <= max_length) ? length : 0;
+}
+
+logger_error_t logger_fifo_drain( logger_fifo_t* self, logger_t* logger, size_t max_records, size_t* drained )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( logger );
+
+	uint8_t			record[LOGGER_FIFO_MAX_RECORD];
+	uint32_t		tail;
+	uint16_t		length;
+	size_t			count = 0;
+	logger_error_t	lerr = LOGGER_OK;
+
+	while( (max_records == 0 || count < max_records) && self->head != self->tail ) {
+		LOGGER_MEMORY_BARRIER();
+		tail = self->tail;
+		length = logger_fifo_record_length(self, tail);
+		DEV_ASSERT(length > 0 && length <= LOGGER_FIFO_MAX_RECORD);
+		logger_fifo_read(self, tail + LOGGER_FIFO_HEADER_BYTES, record, length);
+		lerr = logger_append(logger, record, length);
+
+		/* A failed record is not tried again, part of it may already be on flash. */
+		LOGGER_MEMORY_BARRIER();
+		self->tail = tail + LOGGER_FIFO_HEADER_BYTES + length;
+		if( lerr != LOGGER_OK ) {
+			break;
+		}
+		++count;
+	}
+
+	if( drained != NULL ) {
+		*drained = count;
+	}
+	return lerr;
+}
+
+uint32_t logger_fifo_overruns( logger_fifo_t const* self )
+{
+	DEV_ASSERT( self );
+
+	return self->overruns;
+}
+
+
+/********************************************************************************/
+/* Initialization Method Definitions											*/
+/********************************************************************************/
+logger_error_t initialize_logger_fifo( logger_fifo_t *self, uint8_t* storage, size_t size )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( storage );
+
+	if( size <= LOGGER_FIFO_HEADER_BYTES || (size & (size - 1)) != 0 ) {
+		return LOGGER_INV_CAP;
+	}
+
+	self->buffer = storage;
+	self->mask = (uint32_t) (size - 1);
+	self->head = 0;
+	self->tail = 0;
+	self->overruns = 0;
+	return LOGGER_OK;
+}
@@ -0,0 +1,204 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_quota.c
+ * @date October 16, 2026
+ * @brief
+ * 		Storage budget shared by several logger_t instances.
+ */
+
+#include <logger_quota.h>
+
+/* logger_quota_enforce( ) keeps one bit per logger. */
+#if LOGGER_QUOTA_MAX_LOGGERS > 32
+#error "LOGGER_QUOTA_MAX_LOGGERS must be 32 or less"
+#endif
+
+/********************************************************************************/
+/* Public Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_quota_register( logger_quota_t* self, logger_t* logger, uint8_t weight )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( logger );
+
+	logger_error_t	lerr;
+	bool_t			registered;
+
+	if( weight == 0 ) {
+		return LOGGER_INV_CAP;
+	}
+
+	xSemaphoreTake(self->mutex, portMAX_DELAY);
+	if( self->count >= LOGGER_QUOTA_MAX_LOGGERS ) {
+		xSemaphoreGive(self->mutex);
+		return LOGGER_TABLE_FULL;
+	}
+	if( logger->byte_quota == 0 ) {
+		/* Only count bytes, the budget does the limiting. */
+		lerr = logger_set_quota(logger, LOGGER_QUOTA_UNLIMITED);
+		if( lerr != LOGGER_OK ) {
+			xSemaphoreGive(self->mutex);
+			return lerr;
+		}
+	}
+
+	/* Under the logger's mutex, so no count it makes is missed or added twice. A logger already */
+	/* registered, here or with another budget, would have its bytes counted twice. */
+	xSemaphoreTake(logger->sync_mutex, portMAX_DELAY);
+	registered = (logger->quota != NULL) ? MUTEX_TURE : MUTEX_FALSE;
+	if( !registered ) {
+		logger->quota = self;
+		logger_quota_count(self, (int64_t) logger->bytes_stored);
+	}
+	xSemaphoreGive(logger->sync_mutex);
+	if( registered ) {
+		xSemaphoreGive(self->mutex);
+		return LOGGER_INV_CAP;
+	}
+	self->loggers[self->count] = logger;
+	self->weights[self->count] = weight;
+	++self->count;
+	xSemaphoreGive(self->mutex);
+
+	return logger_quota_enforce(self);
+}
+
+void logger_quota_unregister( logger_quota_t* self, logger_t* logger )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( logger );
+
+	size_t i;
+
+	xSemaphoreTake(self->mutex, portMAX_DELAY);
+	for( i = 0; i < self->count; ++i ) {
+		if( self->loggers[i] == logger ) {
+			--self->count;
+			self->loggers[i] = self->loggers[self->count];
+			self->weights[i] = self->weights[self->count];
+			xSemaphoreTake(logger->sync_mutex, portMAX_DELAY);
+			logger_quota_count(self, -(int64_t) logger->bytes_stored);
+			logger->quota = NULL;
+			xSemaphoreGive(logger->sync_mutex);
+			break;
+		}
+	}
+	xSemaphoreGive(self->mutex);
+}
+
+logger_error_t logger_quota_enforce( logger_quota_t* self )
+{
+	DEV_ASSERT( self );
+
+	uint64_t		bytes[LOGGER_QUOTA_MAX_LOGGERS];
+	uint64_t		total = 0;
+	uint64_t		freed;
+	uint32_t		exhausted = 0;
+	size_t			victim;
+	size_t			i;
+	logger_error_t	lerr = LOGGER_OK;
+
+	xSemaphoreTake(self->mutex, portMAX_DELAY);
+
+	/* Only the victim's count changes below, so sample each logger once. */
+	for( i = 0; i < self->count; ++i ) {
+		bytes[i] = logger_bytes_stored(self->loggers[i]);
+		total += bytes[i];
+	}
+
+	while( total > self->budget ) {
+		/* Furthest over its share is the largest bytes / weight. Cross multiply to stay in integers. */
+		victim = self->count;
+		for( i = 0; i < self->count; ++i ) {
+			if( exhausted & ((uint32_t) 1 << i) ) {
+				continue;
+			}
+			if( victim == self->count ||
+				bytes[i] * self->weights[victim] > bytes[victim] * self->weights[i] ) {
+				victim = i;
+			}
+		}
+		if( victim == self->count ) {
+			/* Nothing left to evict but HEADs. */
+			lerr = LOGGER_NVMEM_FULL;
+			break;
+		}
+
+		lerr = logger_drop_tail(self->loggers[victim], &freed);
+		if( lerr == LOGGER_EMPTY ) {
+			exhausted |= (uint32_t) 1 << victim;
+			lerr = LOGGER_OK;
+			continue;
+		}
+		if( lerr != LOGGER_OK ) {
+			break;
+		}
+		freed = (freed > bytes[victim]) ? bytes[victim] : freed;
+		bytes[victim] -= freed;
+		total -= freed;
+	}
+
+	xSemaphoreGive(self->mutex);
+	return lerr;
+}
+
+uint64_t logger_quota_used( logger_quota_t* self )
+{
+	DEV_ASSERT( self );
+
+	uint64_t used;
+
+	/* 64 bits aren't read in one access on the target. */
+	taskENTER_CRITICAL();
+	used = self->used;
+	taskEXIT_CRITICAL();
+	return used;
+}
+
+void logger_quota_count( logger_quota_t* self, int64_t bytes )
+{
+	DEV_ASSERT( self );
+
+	taskENTER_CRITICAL();
+	if( bytes < 0 && (uint64_t) -bytes > self->used ) {
+		self->used = 0;
+	} else {
+		self->used += (uint64_t) bytes;
+	}
+	taskEXIT_CRITICAL();
+}
+
+bool_t logger_quota_exceeded( logger_quota_t* self )
+{
+	DEV_ASSERT( self );
+
+	return (logger_quota_used(self) > self->budget) ? MUTEX_TURE : MUTEX_FALSE;
+}
+
+
+/********************************************************************************/
+/* Initialization Method Definitions											*/
+/********************************************************************************/
+logger_error_t initialize_logger_quota( logger_quota_t *self, uint64_t budget )
+{
+	DEV_ASSERT( self );
+
+	self->budget = budget;
+	self->count = 0;
+	self->used = 0;
+	self->mutex = xSemaphoreCreateMutex();
+	if( self->mutex == NULL ) {
+		return LOGGER_MUTEX_ERR;
+	}
+	return LOGGER_OK;
+}
@@ -0,0 +1,434 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+/**
+ * @file logger_segment.c
+ * @date October 16, 2026
+ * @brief
+ * 		Segment elements, many time stamped records in one element with a footer index.
+ */
+
+#include <string.h>
+#include <logger_segment.h>
+#include <logger_crc.h>
+#include <logger_endian.h>
+
+/* Index entries read per red_read( ) when checking the footer. */
+#define LOGGER_SEGMENT_READ_ENTRIES 16
+
+/********************************************************************************/
+/* Private Method Definitions													*/
+/********************************************************************************/
+/**
+ * @memberof logger_segment_t @private
+ * @brief
+ * 		Make sure the next record starts a segment at the beginning of a fresh element.
+ */
+static logger_error_t logger_segment_start( logger_segment_t* self )
+{
+	DEV_ASSERT(self);
+
+	logger_error_t lerr;
+
+	lerr = logger_cursor_open(self->logger, &self->cursor);
+	if( lerr == LOGGER_OK && self->cursor.offset != 0 ) {
+		/* The HEAD already has data in it, from before a reset or another writer. */
+		lerr = logger_rotate(self->logger);
+		if( lerr == LOGGER_OK ) {
+			lerr = logger_cursor_open(self->logger, &self->cursor);
+		}
+	}
+	self->length = 0;
+	return lerr;
+}
+
+/**
+ * @memberof logger_segment_t @private
+ * @brief
+ * 		After a failed write, cut the HEAD back to the end of the last frame that reached it whole.
+ * @details
+ * 		Frames still staged by the logger are lost with the write that failed, they are dropped from
+ * 		the index too. If the HEAD can't be cut back the next write finds it moved, see
+ * 		logger_segment_write( ).
+ * @param element
+ * 		The element the frame was written to.
+ */
+static void logger_segment_cut( logger_segment_t* self, logger_position_t const* element )
+{
+	DEV_ASSERT(self);
+	DEV_ASSERT(element);
+
+	if( logger_cursor_open(self->logger, &self->cursor) != LOGGER_OK ) {
+		return;
+	}
+	if( self->cursor.element.temporal != element->temporal ) {
+		/* The HEAD rotated before the frame, the old segment is left without a footer. */
+		self->count = 0;
+		self->length = 0;
+	}
+	while( self->count > 0 && self->length > self->cursor.offset ) {
+		--self->count;
+		self->length = logger_get_u32(self->index + self->count * LOGGER_SEGMENT_INDEX_ENTRY);
+	}
+	if( self->length <= self->cursor.offset ) {
+		logger_cursor_truncate(&self->cursor, self->length);
+	}
+}
+
+/**
+ * @memberof logger_segment_reader_t @private
+ * @brief
+ * 		Read exactly <b>length</b> bytes at <b>offset</b>.
+ */
+static bool_t logger_segment_read_at( logger_segment_reader_t* self, uint32_t offset, uint8_t* buffer, size_t length )
+{
+	DEV_ASSERT(self);
+
+	if( red_lseek(self->handle, offset, RED_SEEK_SET) == RED_FILE_ERR ) {
+		return MUTEX_FALSE;
+	}
+	return red_read(self->handle, buffer, (uint32_t) length) == (int32_t) length;
+}
+
+/**
+ * @memberof logger_segment_reader_t @private
+ * @brief
+ * 		Read the index entry of record <b>k</b>.
+ */
+static bool_t logger_segment_entry( logger_segment_reader_t* self, uint32_t k, uint32_t* offset, uint32_t* timestamp )
+{
+	DEV_ASSERT(self);
+
+	uint8_t entry[LOGGER_SEGMENT_INDEX_ENTRY];
+
+	if( !logger_segment_read_at(self, self->end + k * LOGGER_SEGMENT_INDEX_ENTRY, entry, sizeof(entry)) ) {
+		return MUTEX_FALSE;
+	}
+	*offset = logger_get_u32(entry);
+	if( timestamp != NULL ) {
+		*timestamp = logger_get_u32(entry + 4);
+	}
+	return MUTEX_TURE;
+}
+
+/**
+ * @memberof logger_segment_reader_t @private
+ * @brief
+ * 		Read the header of the frame at the reader's position.
+ * @returns
+ * 		MUTEX_FALSE if there is no whole frame there.
+ */
+static bool_t logger_segment_header( logger_segment_reader_t* self, uint16_t* length, uint32_t* timestamp )
+{
+	DEV_ASSERT(self);
+
+	uint8_t header[LOGGER_SEGMENT_HEADER_LENGTH];
+
+	if( self->position + LOGGER_SEGMENT_FRAME_OVERHEAD > self->end ||
+		!logger_segment_read_at(self, self->position, header, sizeof(header)) ) {
+		return MUTEX_FALSE;
+	}
+	*length = logger_get_u16(header);
+	*timestamp = logger_get_u32(header + 2);
+	return self->position + LOGGER_SEGMENT_FRAME_OVERHEAD + *length <= self->end;
+}
+
+
+/********************************************************************************/
+/* Writer Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_segment_write( logger_segment_t* self, uint32_t timestamp, void const* data, size_t length )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( data || length == 0 );
+
+	logger_error_t	lerr;
+	size_t			frame_length = length + LOGGER_SEGMENT_FRAME_OVERHEAD;
+	logger_position_t	element;
+	uint8_t*		entry;
+
+	if( length > LOGGER_SEGMENT_MAX_RECORD ) {
+		return LOGGER_INV_CAP;
+	}
+
+	/* Close the segment if the record and a footer indexing it won't fit. */
+	if( self->count == LOGGER_SEGMENT_MAX_RECORDS ||
+		(self->count > 0 && self->max_bytes != 0 &&
+		 self->length + frame_length + (self->count + 1) * LOGGER_SEGMENT_INDEX_ENTRY + LOGGER_SEGMENT_TRAILER_LENGTH > self->max_bytes) ) {
+		lerr = logger_segment_close(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+	if( self->count == 0 ) {
+		lerr = logger_segment_start(self);
+		if( lerr != LOGGER_OK ) {
+			return lerr;
+		}
+	}
+
+	logger_put_u16(self->frame, (uint16_t) length);
+	logger_put_u32(self->frame + 2, timestamp);
+	memcpy(self->frame + LOGGER_SEGMENT_HEADER_LENGTH, data, length);
+	logger_put_u32(self->frame + LOGGER_SEGMENT_HEADER_LENGTH + length,
+				   logger_crc32(LOGGER_CRC32_INIT, self->frame, LOGGER_SEGMENT_HEADER_LENGTH + length));
+
+	element = self->cursor.element;
+	lerr = logger_cursor_write(&self->cursor, self->frame, frame_length);
+	if( lerr != LOGGER_OK ) {
+		logger_segment_cut(self, &element);
+		return lerr;
+	}
+	if( self->cursor.offset != self->length || self->cursor.element.temporal != element.temporal ) {
+		/* Something else moved the HEAD, the old segment is left without a footer. */
+		self->count = 0;
+		self->length = self->cursor.offset;
+	}
+
+	entry = self->index + self->count * LOGGER_SEGMENT_INDEX_ENTRY;
+	logger_put_u32(entry, (uint32_t) self->length);
+	logger_put_u32(entry + 4, timestamp);
+	self->length += frame_length;
+	++self->count;
+	return LOGGER_OK;
+}
+
+logger_error_t logger_segment_close( logger_segment_t* self )
+{
+	DEV_ASSERT( self );
+
+	logger_error_t	lerr;
+	size_t			index_length = self->count * LOGGER_SEGMENT_INDEX_ENTRY;
+	uint8_t*		trailer = self->index + index_length;
+
+	if( self->count == 0 ) {
+		return LOGGER_OK;
+	}
+
+	logger_put_u32(trailer, self->count);
+	logger_put_u32(trailer + 4, logger_crc32(LOGGER_CRC32_INIT, self->index, index_length + 4));
+	logger_put_u32(trailer + 8, LOGGER_SEGMENT_MAGIC);
+	lerr = logger_cursor_write(&self->cursor, self->index, index_length + LOGGER_SEGMENT_TRAILER_LENGTH);
+	if( lerr != LOGGER_OK ) {
+		return lerr;
+	}
+	self->count = 0;
+	return logger_rotate(self->logger);
+}
+
+logger_error_t logger_segment_flush( logger_segment_t* self )
+{
+	DEV_ASSERT( self );
+
+	return logger_flush(self->logger);
+}
+
+
+/********************************************************************************/
+/* Reader Method Definitions													*/
+/********************************************************************************/
+logger_error_t logger_segment_reader_open( logger_segment_reader_t* self, int32_t handle )
+{
+	DEV_ASSERT( self );
+
+	uint8_t		trailer[LOGGER_SEGMENT_TRAILER_LENGTH];
+	uint8_t		entries[LOGGER_SEGMENT_READ_ENTRIES*LOGGER_SEGMENT_INDEX_ENTRY];
+	int64_t		size;
+	uint32_t	crc = LOGGER_CRC32_INIT;
+	uint32_t	offset, left, chunk;
+
+	self->handle = handle;
+	self->indexed = MUTEX_FALSE;
+	self->count = 0;
+	self->position = 0;
+
+	size = red_lseek(handle, 0, RED_SEEK_END);
+	if( RED_FILE_ERR == size ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	self->end = (uint32_t) size;
+
+	/* Without a valid footer the frames are walked instead. */
+	if( size < LOGGER_SEGMENT_TRAILER_LENGTH ||
+		!logger_segment_read_at(self, (uint32_t) size - LOGGER_SEGMENT_TRAILER_LENGTH, trailer, sizeof(trailer)) ||
+		logger_get_u32(trailer + 8) != LOGGER_SEGMENT_MAGIC ) {
+		return LOGGER_OK;
+	}
+	self->count = logger_get_u32(trailer);
+	if( self->count > ((uint32_t) size - LOGGER_SEGMENT_TRAILER_LENGTH) / LOGGER_SEGMENT_INDEX_ENTRY ) {
+		self->count = 0;
+		return LOGGER_OK;
+	}
+
+	/* Check the index in one sequential pass. */
+	offset = (uint32_t) size - LOGGER_SEGMENT_TRAILER_LENGTH - self->count * LOGGER_SEGMENT_INDEX_ENTRY;
+	for( left = self->count * LOGGER_SEGMENT_INDEX_ENTRY; left > 0; left -= chunk ) {
+		chunk = (left > sizeof(entries)) ? (uint32_t) sizeof(entries) : left;
+		if( !logger_segment_read_at(self, (uint32_t) size - LOGGER_SEGMENT_TRAILER_LENGTH - left, entries, chunk) ) {
+			return LOGGER_NVMEM_ERR;
+		}
+		crc = logger_crc32(crc, entries, chunk);
+	}
+	crc = logger_crc32(crc, trailer, 4);
+	if( crc != logger_get_u32(trailer + 4) ) {
+		self->count = 0;
+		return LOGGER_OK;
+	}
+
+	self->end = offset;
+	self->indexed = MUTEX_TURE;
+	return LOGGER_OK;
+}
+
+logger_error_t logger_segment_seek( logger_segment_reader_t* self, uint32_t k )
+{
+	DEV_ASSERT( self );
+
+	uint32_t	offset, timestamp, i;
+	uint16_t	length;
+
+	if( self->indexed ) {
+		if( k >= self->count ) {
+			return LOGGER_EMPTY;
+		}
+		if( !logger_segment_entry(self, k, &offset, NULL) ) {
+			return LOGGER_NVMEM_ERR;
+		}
+		self->position = offset;
+		return LOGGER_OK;
+	}
+
+	self->position = 0;
+	for( i = 0; i < k; ++i ) {
+		if( !logger_segment_header(self, &length, &timestamp) ) {
+			return LOGGER_EMPTY;
+		}
+		self->position += LOGGER_SEGMENT_FRAME_OVERHEAD + length;
+	}
+	return logger_segment_header(self, &length, &timestamp) ? LOGGER_OK : LOGGER_EMPTY;
+}
+
+logger_error_t logger_segment_find( logger_segment_reader_t* self, uint32_t timestamp, uint32_t* k )
+{
+	DEV_ASSERT( self );
+
+	uint32_t	low, high, middle, offset, stamp;
+	uint16_t	length;
+
+	if( self->indexed ) {
+		/* First entry stamped at or after timestamp. */
+		low = 0;
+		high = self->count;
+		while( low < high ) {
+			middle = low + (high - low) / 2;
+			if( !logger_segment_entry(self, middle, &offset, &stamp) ) {
+				return LOGGER_NVMEM_ERR;
+			}
+			if( stamp < timestamp ) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		if( k != NULL ) {
+			*k = low;
+		}
+		return logger_segment_seek(self, low);
+	}
+
+	self->position = 0;
+	for( low = 0; logger_segment_header(self, &length, &stamp); ++low ) {
+		if( stamp >= timestamp ) {
+			if( k != NULL ) {
+				*k = low;
+			}
+			return LOGGER_OK;
+		}
+		self->position += LOGGER_SEGMENT_FRAME_OVERHEAD + length;
+	}
+	if( k != NULL ) {
+		*k = low;
+	}
+	return LOGGER_EMPTY;
+}
+
+logger_error_t logger_segment_read( logger_segment_reader_t* self, void* buffer, size_t size, size_t* length, uint32_t* timestamp )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( buffer );
+	DEV_ASSERT( length );
+
+	uint8_t		header[LOGGER_SEGMENT_HEADER_LENGTH];
+	uint8_t		crc[4];
+	uint16_t	record_length;
+	uint32_t	stamp;
+
+	if( !logger_segment_header(self, &record_length, &stamp) ) {
+		return LOGGER_EMPTY;
+	}
+	*length = record_length;
+	if( record_length > size ) {
+		return LOGGER_INV_CAP;
+	}
+	if( red_read(self->handle, buffer, record_length) != (int32_t) record_length ||
+		red_read(self->handle, crc, sizeof(crc)) != (int32_t) sizeof(crc) ) {
+		return LOGGER_NVMEM_ERR;
+	}
+
+	logger_put_u16(header, record_length);
+	logger_put_u32(header + 2, stamp);
+	if( logger_crc32(logger_crc32(LOGGER_CRC32_INIT, header, sizeof(header)), buffer, record_length) != logger_get_u32(crc) ) {
+		return LOGGER_NVMEM_ERR;
+	}
+	if( timestamp != NULL ) {
+		*timestamp = stamp;
+	}
+	self->position += LOGGER_SEGMENT_FRAME_OVERHEAD + record_length;
+	return LOGGER_OK;
+}
+
+uint32_t logger_segment_count( logger_segment_reader_t* self )
+{
+	DEV_ASSERT( self );
+
+	uint32_t	count, position, timestamp;
+	uint16_t	length;
+
+	if( self->indexed ) {
+		return self->count;
+	}
+
+	/* Walk the frames, then put the reader back where it was. */
+	position = self->position;
+	self->position = 0;
+	for( count = 0; logger_segment_header(self, &length, &timestamp); ++count ) {
+		self->position += LOGGER_SEGMENT_FRAME_OVERHEAD + length;
+	}
+	self->position = position;
+	return count;
+}
+
+
+/********************************************************************************/
+/* Initialization Method Definitions											*/
+/********************************************************************************/
+logger_error_t initialize_logger_segment( logger_segment_t *self, logger_t* logger, size_t max_bytes )
+{
+	DEV_ASSERT( self );
+	DEV_ASSERT( logger );
+
+	self->logger = logger;
+	self->max_bytes = max_bytes;
+	self->length = 0;
+	self->count = 0;
+	logger_set_rotation(logger, 0, 0);
+	return LOGGER_OK;
+}